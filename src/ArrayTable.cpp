@@ -0,0 +1,167 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "ArrayTable.hpp"
+
+namespace usql {
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+    namespace {
+        enum {
+            ValueColumn = 0,
+            PointerColumn = 1
+        };
+        
+        void resultValue(sqlite3_context *context, int64_t value) {
+            sqlite3_result_int64(context, static_cast<sqlite3_int64>(value));
+        }
+        
+        void resultValue(sqlite3_context *context, double value) {
+            sqlite3_result_double(context, value);
+        }
+        
+        //the text lives as long as the binding, which outlives every row of the statement
+        void resultValue(sqlite3_context *context, const std::string &value) {
+            sqlite3_result_text(context, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
+        }
+        
+        template<class T>
+        class TypedArrayValues : public ArrayValues
+        {
+        public:
+            template<class Iterator>
+            TypedArrayValues(Iterator begin, Iterator end) : _values(begin, end) {}
+            
+            virtual size_t size() const {
+                return _values.size();
+            }
+            
+            virtual void result(sqlite3_context *context, size_t i) const {
+                resultValue(context, _values[i]);
+            }
+            
+        private:
+            std::vector<T> _values;
+        };
+    }
+    
+    ArrayValues *ArrayValues::create(const std::vector<int> &values) {
+        return new TypedArrayValues<int64_t>(values.begin(), values.end());
+    }
+    
+    ArrayValues *ArrayValues::create(const std::vector<int64_t> &values) {
+        return new TypedArrayValues<int64_t>(values.begin(), values.end());
+    }
+    
+    ArrayValues *ArrayValues::create(const std::vector<double> &values) {
+        return new TypedArrayValues<double>(values.begin(), values.end());
+    }
+    
+    ArrayValues *ArrayValues::create(const std::vector<std::string> &values) {
+        return new TypedArrayValues<std::string>(values.begin(), values.end());
+    }
+    
+    void ArrayValues::release(void *p) {
+        delete static_cast<ArrayValues *>(p);
+    }
+    
+    class ArrayTable::Cursor : public VirtualTableCursor
+    {
+    public:
+        Cursor() : _values(nullptr), _pos(0) {}
+        
+        virtual int filter(int idxNum, const char *, const FunctionArguments &argv) {
+            _values = nullptr;
+            _pos = 0;
+            if (idxNum == 1 && argv.size() == 1) {
+                _values = static_cast<const ArrayValues *>(sqlite3_value_pointer(argv[0], pointerType()));
+            }
+            
+            return SQLITE_OK;
+        }
+        
+        virtual int next() {
+            ++_pos;
+            return SQLITE_OK;
+        }
+        
+        virtual bool eof() const {
+            return !_values || _pos >= _values->size();
+        }
+        
+        virtual int column(sqlite3_context *context, int column) {
+            if (column == ValueColumn) {
+                _values->result(context, _pos);
+            }
+            else {
+                sqlite3_result_null(context);
+            }
+            
+            return SQLITE_OK;
+        }
+        
+        virtual sqlite3_int64 rowid() const {
+            return static_cast<sqlite3_int64>(_pos + 1);
+        }
+        
+    private:
+        const ArrayValues *_values;
+        size_t _pos;
+    };
+    
+    std::string ArrayTable::declaration() const {
+        return "create table x(value, pointer hidden)";
+    }
+    
+    int ArrayTable::bestIndex(sqlite3_index_info *info) {
+        for (int i = 0; i < info->nConstraint; ++i) {
+            const sqlite3_index_info::sqlite3_index_constraint &constraint = info->aConstraint[i];
+            if (constraint.iColumn == PointerColumn && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ && constraint.usable) {
+                info->aConstraintUsage[i].argvIndex = 1;
+                info->aConstraintUsage[i].omit = 1;
+                info->idxNum = 1;
+                info->estimatedCost = 1;
+#if SQLITE_VERSION_NUMBER >= 3008002
+                info->estimatedRows = 100;
+#endif
+                return SQLITE_OK;
+            }
+        }
+        
+        //without the list the table is empty, sqlite is steered to plans that pass it
+        info->idxNum = 0;
+        info->estimatedCost = 2147483647;
+#if SQLITE_VERSION_NUMBER >= 3008002
+        info->estimatedRows = 2147483647;
+#endif
+        return SQLITE_OK;
+    }
+    
+    VirtualTableCursor *ArrayTable::openCursor() {
+        return new Cursor();
+    }
+#endif
+}
@@ -0,0 +1,80 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef ArrayTable_hpp
+#define ArrayTable_hpp
+
+#include "StdCpp.hpp"
+#include "VirtualTable.hpp"
+
+namespace usql {
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+    //a list bound to one parameter, owned by the statement until it is rebound or cleared
+    class ArrayValues
+    {
+    public:
+        virtual ~ArrayValues() {}
+        
+        virtual size_t size() const = 0;
+        virtual void result(sqlite3_context *context, size_t i) const = 0;
+        
+        static ArrayValues *create(const std::vector<int> &values);
+        static ArrayValues *create(const std::vector<int64_t> &values);
+        static ArrayValues *create(const std::vector<double> &values);
+        static ArrayValues *create(const std::vector<std::string> &values);
+        
+        //the destructor passed to sqlite3_bind_pointer
+        static void release(void *p);
+    };
+    
+    //the table valued function behind Cursor::bind of a std::vector, every connection has it:
+    //    select * from t where id in usql_array(?)
+    //    select value from usql_array(:ids)
+    //one prepared statement serves lists of any size; without a bound list the table is empty
+    class ArrayTable : public VirtualTable
+    {
+    public:
+        static const char *tableName() {
+            return "usql_array";
+        }
+        
+        //sqlite3_value_pointer only hands out a pointer bound with this exact type
+        static const char *pointerType() {
+            return "usql_array";
+        }
+        
+        virtual std::string declaration() const;
+        virtual int bestIndex(sqlite3_index_info *info);
+        virtual VirtualTableCursor *openCursor();
+        
+    private:
+        class Cursor;
+    };
+#endif
+}
+
+#endif /* ArrayTable_hpp */
@@ -0,0 +1,186 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "BlobStream.hpp"
+#include "Connection.hpp"
+
+namespace usql {
+    BlobStream::BlobStream(Connection &con)
+    : _db(con.database())
+    , _blob(nullptr)
+    , _size(0)
+    , _offset(0) {
+    }
+    
+    BlobStream::~BlobStream() {
+        close();
+    }
+    
+    Result BlobStream::open(const std::string &table, const std::string &column, sqlite3_int64 rowid, bool writable, const std::string &schema) {
+        close();
+        
+        _Database db = _db.lock();
+        if (!db || !db->isOpening() || table.empty() || column.empty()) {
+            return false;
+        }
+        
+        int code = sqlite3_blob_open(db->db(), schema.empty() ? "main" : schema.c_str(), table.c_str(), column.c_str(), rowid, writable ? 1 : 0, &_blob);
+        if (!_USQL_OK(code)) {
+            //the handle is set to null on failure, a blob that failed to open needs no close
+            _blob = nullptr;
+            return Result(code, db);
+        }
+        
+        _size = sqlite3_blob_bytes(_blob);
+        _offset = 0;
+        return Result::success();
+    }
+    
+    Result BlobStream::reopen(sqlite3_int64 rowid) {
+        if (!_blob) {
+            return false;
+        }
+        
+        int code = sqlite3_blob_reopen(_blob, rowid);
+        if (!_USQL_OK(code)) {
+            //the handle is aborted, only close() is left
+            _size = 0;
+            _offset = 0;
+            return Result(code, _db);
+        }
+        
+        _size = sqlite3_blob_bytes(_blob);
+        _offset = 0;
+        return Result::success();
+    }
+    
+    Result BlobStream::close() {
+        if (!_blob) {
+            return Result::success();
+        }
+        
+        int code = sqlite3_blob_close(_blob);
+        _blob = nullptr;
+        _size = 0;
+        _offset = 0;
+        return Result(code, _db);
+    }
+    
+    Result BlobStream::read(void *buffer, int count, int offset) {
+        if (!_blob || !buffer || count < 0 || offset < 0) {
+            return false;
+        }
+        
+        return Result(sqlite3_blob_read(_blob, buffer, count, offset), _db);
+    }
+    
+    Result BlobStream::write(const void *data, int count, int offset) {
+        if (!_blob || !data || count < 0 || offset < 0) {
+            return false;
+        }
+        
+        return Result(sqlite3_blob_write(_blob, data, count, offset), _db);
+    }
+    
+    BlobView BlobStream::readChunk(int count) {
+        int n = std::min(count, _size - _offset);
+        if (!_blob || n <= 0) {
+            return BlobView();
+        }
+        
+        char *p = buffer(n);
+        if (!read(p, n, _offset)) {
+            return BlobView();
+        }
+        
+        _offset += n;
+        return BlobView(reinterpret_cast<const unsigned char *>(p), static_cast<size_t>(n));
+    }
+    
+    Result BlobStream::write(const void *data, int count) {
+        Result ret = write(data, count, _offset);
+        if (ret) {
+            _offset += count;
+        }
+        
+        return ret;
+    }
+    
+    Result BlobStream::readTo(std::ostream &out, int chunkSize) {
+        if (!_blob || chunkSize <= 0) {
+            return false;
+        }
+        
+        while (_offset < _size) {
+            int n = std::min(chunkSize, _size - _offset);
+            char *p = buffer(n);
+            Result ret = read(p, n, _offset);
+            if (!ret) {
+                return ret;
+            }
+            
+            if (!out.write(p, n)) {
+                return Result(SQLITE_IOERR, _USQL_SQLITE_ERRSTR(SQLITE_IOERR));
+            }
+            _offset += n;
+        }
+        
+        return Result::success();
+    }
+    
+    Result BlobStream::writeFrom(std::istream &in, int chunkSize) {
+        if (!_blob || chunkSize <= 0) {
+            return false;
+        }
+        
+        while (_offset < _size && in) {
+            int n = std::min(chunkSize, _size - _offset);
+            char *p = buffer(n);
+            in.read(p, n);
+            int got = static_cast<int>(in.gcount());
+            if (got <= 0) {
+                break;
+            }
+            
+            Result ret = write(p, got, _offset);
+            if (!ret) {
+                return ret;
+            }
+            _offset += got;
+        }
+        
+        return Result::success();
+    }
+    
+    char *BlobStream::buffer(int size) {
+        if (_buffer.size() < static_cast<size_t>(size)) {
+            _buffer.resize(size);
+        }
+        
+        return _buffer.data();
+    }
+}
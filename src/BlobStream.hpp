@@ -0,0 +1,104 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef BlobStream_hpp
+#define BlobStream_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Result.hpp"
+#include "DataView.hpp"
+#include "Database.hpp"
+#include <iostream>
+
+namespace usql {
+    class Connection;
+    
+    //incremental access to one blob cell through sqlite3_blob_*, nothing is read or written
+    //that is not asked for; a blob can not grow, preallocate it with Cursor::bindZeroBlob.
+    //the stream must be closed before its connection
+    class BlobStream : public NoCopyable
+    {
+    public:
+        BlobStream(Connection &con);
+        virtual ~BlobStream();
+        
+        Result open(const std::string &table, const std::string &column, sqlite3_int64 rowid, bool writable = false, const std::string &schema = "main");
+        //moves to another row of the same column, cheaper than close() and open()
+        Result reopen(sqlite3_int64 rowid);
+        Result close();
+        
+        bool isOpen() const {
+            return _blob != nullptr;
+        }
+        
+        int size() const {
+            return _size;
+        }
+        
+        //position of the sequential read and write
+        int tell() const {
+            return _offset;
+        }
+        
+        void seek(int offset) {
+            _offset = std::max(0, std::min(offset, _size));
+        }
+        
+        bool eof() const {
+            return _offset >= _size;
+        }
+        
+        //exactly count bytes at offset, fails past the end
+        Result read(void *buffer, int count, int offset);
+        Result write(const void *data, int count, int offset);
+        
+        //next count bytes at most, into a buffer reused by every chunk;
+        //the view is valid until the next chunk, an empty view at the end
+        BlobView readChunk(int count = USQL_DEFAULT_BLOB_CHUNK_SIZE);
+        //count bytes at tell()
+        Result write(const void *data, int count);
+        
+        //streams from tell() to the end through the reused buffer
+        Result readTo(std::ostream &out, int chunkSize = USQL_DEFAULT_BLOB_CHUNK_SIZE);
+        //streams until the input ends or the blob is full, the input left over is not consumed
+        Result writeFrom(std::istream &in, int chunkSize = USQL_DEFAULT_BLOB_CHUNK_SIZE);
+        
+    private:
+        char *buffer(int size);
+        
+    private:
+        _WeakDatabase _db;
+        sqlite3_blob *_blob;
+        int _size;
+        int _offset;
+        std::vector<char> _buffer;
+    };
+}
+
+#endif /* BlobStream_hpp */
@@ -0,0 +1,202 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "BulkInserter.hpp"
+#include "Connection.hpp"
+
+namespace usql {
+    BulkInserter::BulkInserter(Connection &con, const std::string &tablename, const std::vector<std::string> &columns)
+    : _connection(con)
+    , _command(insertCommand(tablename, columns))
+    , _columnCount(columns.size())
+    , _cursor(_command, con)
+    , _batchRows(USQL_DEFAULT_BULK_INSERT_BATCH_ROWS)
+    , _batchInterval(0)
+    , _inTransaction(false)
+    , _pendingRows(0)
+    , _rowCount(0)
+    , _commitCount(0)
+    , _started(false) {
+    }
+    
+    BulkInserter::~BulkInserter() {
+        flush();
+    }
+    
+    std::string BulkInserter::insertCommand(const std::string &tablename, const std::vector<std::string> &columns) {
+        if (tablename.empty() || columns.empty()) {
+            return "";
+        }
+        
+        std::stringstream names;
+        std::stringstream values;
+        for (auto iter = columns.begin(); iter != columns.end(); ++iter) {
+            if (iter != columns.begin()) {
+                names<<", ";
+                values<<", ";
+            }
+            
+            names<<*iter;
+            values<<"?";
+        }
+        
+        std::stringstream buf;
+        buf<<"INSERT INTO "<<tablename<<" ("<<names.str()<<") VALUES ("<<values.str()<<")";
+        return buf.str();
+    }
+    
+    Result BulkInserter::begin() {
+        if (_inTransaction) {
+            return Result::success();
+        }
+        
+        Result ret = _connection.beginTransaction(_USQL_ENUM_VALUE(TransactionType, Immediate));
+        if (!ret) {
+            return ret;
+        }
+        
+        _inTransaction = true;
+        _pendingRows = 0;
+        _batchBegin = std::chrono::steady_clock::now();
+        if (!_started) {
+            _started = true;
+            _begin = _batchBegin;
+        }
+        
+        return ret;
+    }
+    
+    Result BulkInserter::step() {
+        Result ret = begin();
+        if (!ret) {
+            return ret;
+        }
+        
+        ret = _cursor.exec();
+        if (!ret) {
+            return ret;
+        }
+        
+        ++_pendingRows;
+        if (_pendingRows >= _batchRows) {
+            return flush();
+        }
+        
+        if (_batchInterval > 0) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _batchBegin);
+            if (elapsed.count() >= _batchInterval) {
+                return flush();
+            }
+        }
+        
+        return ret;
+    }
+    
+    Result BulkInserter::insert(const ColumnBatch &batch) {
+        if (batch.columnCount() != static_cast<int>(_columnCount)) {
+            return Result::error();
+        }
+        
+        for (size_t row = 0; row < batch.rowCount(); ++row) {
+            for (int i = 0; i < batch.columnCount(); ++i) {
+                const ColumnBatch::Column &column = batch.column(i);
+                int idx = i + 1;
+                Result ret(true);
+                if (column.isNull(row)) {
+                    ret = _cursor.bindNull(idx);
+                }
+                else if (column.type() == _USQL_ENUM_VALUE(ColumnType, Integer)) {
+                    ret = _cursor.bind(idx, static_cast<sqlite3_int64>(column.ints()[row]));
+                }
+                else if (column.type() == _USQL_ENUM_VALUE(ColumnType, Float)) {
+                    ret = _cursor.bind(idx, column.floats()[row]);
+                }
+                //only isNull() decides NULL, an empty value is bound through a non-null pointer so it stays '' or x''
+                else if (column.type() == _USQL_ENUM_VALUE(ColumnType, Text)) {
+                    TextView text = column.text(row);
+                    ret = _cursor.bind(idx, text.empty() ? TextView("", 0) : text, _USQL_ENUM_VALUE(BindType, Static));
+                }
+                else if (column.type() == _USQL_ENUM_VALUE(ColumnType, Blob)) {
+                    BlobView blob = column.blob(row);
+                    ret = _cursor.bind(idx, blob.empty() ? BlobView(reinterpret_cast<const unsigned char *>(""), 0) : blob, _USQL_ENUM_VALUE(BindType, Static));
+                }
+                else {
+                    ret = _cursor.bindNull(idx);
+                }
+                
+                if (!ret) {
+                    return ret;
+                }
+            }
+            
+            Result ret = step();
+            if (!ret) {
+                return ret;
+            }
+        }
+        
+        return Result::success();
+    }
+    
+    Result BulkInserter::flush() {
+        if (!_inTransaction) {
+            return Result::success();
+        }
+        
+        Result ret = _connection.commit();
+        if (!ret) {
+            return ret;
+        }
+        
+        _inTransaction = false;
+        _rowCount += _pendingRows;
+        _pendingRows = 0;
+        ++_commitCount;
+        _end = std::chrono::steady_clock::now();
+        
+        return ret;
+    }
+    
+    Result BulkInserter::rollback() {
+        if (!_inTransaction) {
+            return Result::success();
+        }
+        
+        _inTransaction = false;
+        _pendingRows = 0;
+        return _connection.rollback();
+    }
+    
+    double BulkInserter::rowsPerSecond() const {
+        if (_commitCount == 0) {
+            return 0;
+        }
+        
+        double seconds = std::chrono::duration<double>(_end - _begin).count();
+        return seconds > 0 ? _rowCount / seconds : 0;
+    }
+}
@@ -0,0 +1,149 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef BulkInserter_hpp
+#define BulkInserter_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Result.hpp"
+#include "DataView.hpp"
+#include "ColumnBatch.hpp"
+#include "Cursor.hpp"
+#include <chrono>
+
+namespace usql {
+    class Connection;
+    
+    //inserts rows through one prepared INSERT, committing an IMMEDIATE transaction every
+    //batchRows rows or batchInterval milliseconds, whichever comes first
+    class BulkInserter : public NoCopyable
+    {
+    public:
+        BulkInserter(Connection &con, const std::string &tablename, const std::vector<std::string> &columns);
+        
+        //commits the pending rows
+        virtual ~BulkInserter();
+        
+        void setBatchRows(size_t rows) {
+            _batchRows = std::max<size_t>(1, rows);
+        }
+        size_t batchRows() const {
+            return _batchRows;
+        }
+        
+        //checked on each insert, 0 disables the time based commit
+        void setBatchInterval(int milliseconds) {
+            _batchInterval = std::max(0, milliseconds);
+        }
+        int batchInterval() const {
+            return _batchInterval;
+        }
+        
+        std::string command() const {
+            return _command;
+        }
+        
+        //binds one value per column, in the order of the column list
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+        template<class... TArgs>
+        Result insert(const TArgs&... values) {
+            if (sizeof...(TArgs) != _columnCount) {
+                return Result::error();
+            }
+            
+            Result ret = _cursor.bindAllStatic(values...);
+            if (!ret) {
+                return ret;
+            }
+            
+            return step();
+        }
+        
+        template<class... TArgs>
+        Result insert(const tr1::tuple<TArgs...> &row) {
+            if (sizeof...(TArgs) != _columnCount) {
+                return Result::error();
+            }
+            
+            Result ret = _cursor.bindAllStatic(row);
+            if (!ret) {
+                return ret;
+            }
+            
+            return step();
+        }
+#endif
+        
+        //inserts every row of the batch, columns are matched by position
+        Result insert(const ColumnBatch &batch);
+        
+        //commits the pending rows
+        Result flush();
+        //drops the pending rows
+        Result rollback();
+        
+        uint64_t rowCount() const {
+            return _rowCount;
+        }
+        
+        uint64_t commitCount() const {
+            return _commitCount;
+        }
+        
+        //committed rows per second, measured from the first insert to the last commit
+        double rowsPerSecond() const;
+        
+    private:
+        static std::string insertCommand(const std::string &tablename, const std::vector<std::string> &columns);
+        
+        Result begin();
+        Result step();
+        
+    private:
+        Connection &_connection;
+        std::string _command;
+        size_t _columnCount;
+        Cursor _cursor;
+        
+        size_t _batchRows;
+        int _batchInterval;
+        
+        bool _inTransaction;
+        size_t _pendingRows;
+        std::chrono::steady_clock::time_point _batchBegin;
+        
+        uint64_t _rowCount;
+        uint64_t _commitCount;
+        bool _started;
+        std::chrono::steady_clock::time_point _begin;
+        std::chrono::steady_clock::time_point _end;
+    };
+}
+
+#endif /* BulkInserter_hpp */
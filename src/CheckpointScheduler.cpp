@@ -0,0 +1,248 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "CheckpointScheduler.hpp"
+#include "Connection.hpp"
+#include "Query.hpp"
+
+namespace usql {
+    CheckpointScheduler::Stats::Stats()
+    : walFrames(0)
+    , lastLogFrames(0)
+    , lastCheckpointedFrames(0)
+    , passiveCheckpoints(0)
+    , restartCheckpoints(0)
+    , truncateCheckpoints(0)
+    , busyCheckpoints(0)
+    , framesCheckpointed(0) {
+    }
+    
+    CheckpointScheduler::CheckpointScheduler(Connection &writer)
+    : _writer(writer)
+    , _connection(nullptr)
+    , _autocheckpoint(0)
+    , _walFrames(USQL_DEFAULT_CHECKPOINT_FRAMES)
+    , _idleTime(USQL_DEFAULT_CHECKPOINT_IDLE_TIME)
+    , _running(false)
+    , _stopping(false)
+    , _baseFrames(0)
+    , _walReset(true)
+    , _idlePending(false) {
+    }
+    
+    CheckpointScheduler::~CheckpointScheduler() {
+        stop();
+    }
+    
+    Result CheckpointScheduler::start() {
+        if (_running) {
+            return Result::success();
+        }
+        
+        if (!_writer.isOpenning()) {
+            return false;
+        }
+        
+        _connection = new Connection(_writer.filename());
+        Result ret = _connection->open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX);
+        if (!ret) {
+            delete _connection;
+            _connection = nullptr;
+            return ret;
+        }
+        _connection->setBusyPolicy(BusyPolicy::backoff(USQL_DEFAULT_POOL_TIMEOUT));
+        
+        //reading the journal mode also opens the wal for the checkpointing connection
+        std::string mode;
+        {
+            Query query("PRAGMA journal_mode", *_connection);
+            if (query.next()) {
+                mode = query.textForColumnIndex(0);
+            }
+        }
+        if (mode != "wal") {
+            delete _connection;
+            _connection = nullptr;
+            return Result(SQLITE_MISUSE, _USQL_SQLITE_ERRSTR(SQLITE_MISUSE));
+        }
+        
+        {
+            Query query("PRAGMA wal_autocheckpoint", _writer);
+            _autocheckpoint = query.next() ? query.intForColumnIndex(0) : 0;
+        }
+        
+        //replaces the hook behind wal_autocheckpoint, so the writer stops checkpointing inline
+        sqlite3_wal_hook(_writer.database().lock()->db(), &CheckpointScheduler::walHook, this);
+        
+        _stopping = false;
+        _baseFrames = 0;
+        _idlePending = false;
+        _lastCommit = Clock::now();
+        _running = true;
+        _thread = std::thread(&CheckpointScheduler::run, this);
+        return ret;
+    }
+    
+    void CheckpointScheduler::stop() {
+        if (!_running) {
+            return;
+        }
+        
+        if (_writer.isOpenning()) {
+            sqlite3 *db = _writer.database().lock()->db();
+            sqlite3_wal_hook(db, nullptr, nullptr);
+            sqlite3_wal_autocheckpoint(db, _autocheckpoint);
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _changed.notify_one();
+        _thread.join();
+        _running = false;
+        
+        //a checkpoint() from another thread holds the connection under _checkpointMutex
+        std::lock_guard<std::mutex> guard(_checkpointMutex);
+        delete _connection;
+        _connection = nullptr;
+    }
+    
+    int CheckpointScheduler::walHook(void *arg, sqlite3 *, const char *, int frames) {
+        CheckpointScheduler *scheduler = static_cast<CheckpointScheduler *>(arg);
+        bool full = false;
+        bool idled = false;
+        {
+            std::lock_guard<std::mutex> lock(scheduler->_mutex);
+            //the writer wrapped around to the start of the wal
+            if (frames < scheduler->_stats.walFrames) {
+                scheduler->_baseFrames = 0;
+                scheduler->_walReset = true;
+            }
+            //the first commit after an idle checkpoint arms the idle deadline
+            idled = !scheduler->_idlePending && scheduler->_idleTime > 0;
+            scheduler->_idlePending = true;
+            scheduler->_stats.walFrames = frames;
+            scheduler->_lastCommit = Clock::now();
+            full = frames - scheduler->_baseFrames >= scheduler->_walFrames;
+        }
+        
+        if (full || idled) {
+            scheduler->_changed.notify_one();
+        }
+        
+        return SQLITE_OK;
+    }
+    
+    void CheckpointScheduler::run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stopping) {
+            int idle = _idleTime;
+            //the idle deadline only matters while a commit is waiting for its TRUNCATE,
+            //otherwise it lies in the past and wait_until would return at once
+            Clock::time_point deadline = idle > 0 && _idlePending ? _lastCommit + std::chrono::milliseconds(idle) : Clock::now() + std::chrono::milliseconds(USQL_DEFAULT_CHECKPOINT_IDLE_TIME);
+            _changed.wait_until(lock, deadline);
+            if (_stopping) {
+                break;
+            }
+            
+            int frames = _stats.walFrames;
+            bool full = frames - _baseFrames >= _walFrames;
+            bool idled = idle > 0 && _idlePending && Clock::now() - _lastCommit >= std::chrono::milliseconds(idle);
+            if (!full && !idled) {
+                continue;
+            }
+            
+            //a wal that keeps growing while PASSIVE falls behind means readers pin old frames,
+            //RESTART waits them out so the writer can wrap around to the start of the wal
+            CheckpointMode mode = _USQL_ENUM_VALUE(CheckpointMode, Passive);
+            if (idled) {
+                mode = _USQL_ENUM_VALUE(CheckpointMode, Truncate);
+            }
+            else if (frames >= _walFrames * 4 && _stats.lastCheckpointedFrames < _stats.lastLogFrames) {
+                mode = _USQL_ENUM_VALUE(CheckpointMode, Restart);
+            }
+            
+            _baseFrames = frames;
+            //a busy TRUNCATE is not retried until the next commit
+            if (idled) {
+                _idlePending = false;
+            }
+            lock.unlock();
+            Result ret = checkpoint(mode);
+            if (!ret && mode == _USQL_ENUM_VALUE(CheckpointMode, Truncate)) {
+                checkpoint(_USQL_ENUM_VALUE(CheckpointMode, Passive));
+            }
+            lock.lock();
+        }
+    }
+    
+    Result CheckpointScheduler::checkpoint(CheckpointMode mode) {
+        std::lock_guard<std::mutex> guard(_checkpointMutex);
+        if (!_connection) {
+            return false;
+        }
+        
+        int log = 0;
+        int checkpointed = 0;
+        Clock::time_point begin = Clock::now();
+        int code = sqlite3_wal_checkpoint_v2(_connection->database().lock()->db(), nullptr, static_cast<int>(mode), &log, &checkpointed);
+        uint64_t duration = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count());
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.durations.record(duration);
+        if (code == SQLITE_BUSY) {
+            ++_stats.busyCheckpoints;
+        }
+        
+        if (code == SQLITE_OK || code == SQLITE_BUSY) {
+            if (mode == _USQL_ENUM_VALUE(CheckpointMode, Truncate)) {
+                ++_stats.truncateCheckpoints;
+            }
+            else if (mode == _USQL_ENUM_VALUE(CheckpointMode, Restart)) {
+                ++_stats.restartCheckpoints;
+            }
+            else {
+                ++_stats.passiveCheckpoints;
+            }
+            
+            //the counts cover the whole wal, frames backfilled by an earlier checkpoint of the same wal are not counted twice
+            int previous = _walReset ? 0 : std::max(0, _stats.lastCheckpointedFrames);
+            _stats.framesCheckpointed += std::max(0, checkpointed - previous);
+            _walReset = code == SQLITE_OK && mode != _USQL_ENUM_VALUE(CheckpointMode, Passive) && mode != _USQL_ENUM_VALUE(CheckpointMode, Full);
+            _stats.lastLogFrames = log;
+            _stats.lastCheckpointedFrames = checkpointed;
+        }
+        
+        return Result(code, _connection->database());
+    }
+    
+    CheckpointScheduler::Stats CheckpointScheduler::stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+}
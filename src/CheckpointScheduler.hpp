@@ -0,0 +1,142 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef CheckpointScheduler_hpp
+#define CheckpointScheduler_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Result.hpp"
+#include "Histogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace usql {
+    class Connection;
+    
+    _USQL_ENUM_CLASS_DEF(CheckpointMode) {
+        Passive = SQLITE_CHECKPOINT_PASSIVE,
+        Full = SQLITE_CHECKPOINT_FULL,
+        Restart = SQLITE_CHECKPOINT_RESTART,
+        Truncate = SQLITE_CHECKPOINT_TRUNCATE
+    };
+    
+    //moves WAL checkpoints off the write path: inline auto-checkpoints of the writer are turned off
+    //and a dedicated connection checkpoints on a background thread once the WAL grew by walFrames
+    //pages or the writer has been idle for idleTime; PASSIVE escalates to RESTART when it falls
+    //behind and the WAL grows past 4 * walFrames, an idle WAL is truncated. RESTART and TRUNCATE
+    //briefly hold the write lock, so the writer should have a busy policy
+    class CheckpointScheduler : public NoCopyable
+    {
+    public:
+        struct Stats
+        {
+            //pages in the WAL after the last commit
+            int walFrames;
+            //pages in the WAL and pages moved into the database by the last checkpoint
+            int lastLogFrames;
+            int lastCheckpointedFrames;
+            
+            uint64_t passiveCheckpoints;
+            uint64_t restartCheckpoints;
+            uint64_t truncateCheckpoints;
+            uint64_t busyCheckpoints;
+            uint64_t framesCheckpointed;
+            //microseconds per checkpoint
+            Histogram durations;
+            
+            Stats();
+        };
+        
+        //must be created and destroyed on the writer's thread,
+        //the connection has to be open in WAL mode on a file
+        CheckpointScheduler(Connection &writer);
+        //stops and restores the writer's auto-checkpoint
+        virtual ~CheckpointScheduler();
+        
+        void setWalFrames(int frames) {
+            _walFrames = std::max(1, frames);
+        }
+        int walFrames() const {
+            return _walFrames;
+        }
+        
+        //milliseconds without a commit before a pending WAL is checkpointed, 0 disables
+        void setIdleTime(int milliseconds) {
+            _idleTime = std::max(0, milliseconds);
+        }
+        int idleTime() const {
+            return _idleTime;
+        }
+        
+        Result start();
+        void stop();
+        
+        bool isRunning() const {
+            return _running;
+        }
+        
+        //runs a checkpoint on the calling thread through the scheduler's connection
+        Result checkpoint(CheckpointMode mode);
+        
+        Stats stats() const;
+        
+    private:
+        typedef std::chrono::steady_clock Clock;
+        
+        static int walHook(void *arg, sqlite3 *db, const char *name, int frames);
+        void run();
+        
+    private:
+        Connection &_writer;
+        Connection *_connection;
+        int _autocheckpoint;
+        
+        std::atomic<int> _walFrames;
+        std::atomic<int> _idleTime;
+        
+        std::thread _thread;
+        std::atomic<bool> _running;
+        bool _stopping;
+        mutable std::mutex _mutex;
+        std::mutex _checkpointMutex;
+        std::condition_variable _changed;
+        
+        //wal pages at the last scheduled checkpoint
+        int _baseFrames;
+        bool _walReset;
+        bool _idlePending;
+        Clock::time_point _lastCommit;
+        Stats _stats;
+    };
+}
+
+#endif /* CheckpointScheduler_hpp */
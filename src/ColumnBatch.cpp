@@ -0,0 +1,185 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "ColumnBatch.hpp"
+
+namespace usql {
+    static inline ColumnType batchColumnType(int type) {
+        switch (type) {
+            case SQLITE_INTEGER:
+                return _USQL_ENUM_VALUE(ColumnType, Integer);
+                
+            case SQLITE_FLOAT:
+                return _USQL_ENUM_VALUE(ColumnType, Float);
+                
+            case SQLITE_TEXT:
+                return _USQL_ENUM_VALUE(ColumnType, Text);
+                
+            case SQLITE_BLOB:
+                return _USQL_ENUM_VALUE(ColumnType, Blob);
+                
+            default:
+                return _USQL_ENUM_VALUE(ColumnType, Null);
+        }
+    }
+    
+#pragma mark - column
+    void ColumnBatch::Column::clear() {
+        _nulls.clear();
+        _ints.clear();
+        _floats.clear();
+        _offsets.clear();
+        _bytes.clear();
+        
+        if (_type == _USQL_ENUM_VALUE(ColumnType, Text) || _type == _USQL_ENUM_VALUE(ColumnType, Blob)) {
+            _offsets.push_back(0);
+        }
+    }
+    
+    void ColumnBatch::Column::setType(ColumnType type, size_t rows) {
+        _type = type;
+        _ints.clear();
+        _floats.clear();
+        _offsets.clear();
+        _bytes.clear();
+        
+        //rows before the type was known were null
+        switch (type) {
+            case _USQL_ENUM_VALUE(ColumnType, Integer):
+                _ints.resize(rows, 0);
+                break;
+                
+            case _USQL_ENUM_VALUE(ColumnType, Float):
+                _floats.resize(rows, 0.0);
+                break;
+                
+            case _USQL_ENUM_VALUE(ColumnType, Text):
+            case _USQL_ENUM_VALUE(ColumnType, Blob):
+                _offsets.resize(rows + 1, 0);
+                break;
+                
+            default:
+                break;
+        }
+    }
+    
+    void ColumnBatch::Column::append(sqlite3_stmt *stmt, int idx, size_t row) {
+        if ((row & 7) == 0) {
+            _nulls.push_back(0);
+        }
+        
+        int t = sqlite3_column_type(stmt, idx);
+        if (t == SQLITE_NULL) {
+            _nulls.back() |= static_cast<uint8_t>(1 << (row & 7));
+        }
+        else if (_type == _USQL_ENUM_VALUE(ColumnType, Null)) {
+            setType(batchColumnType(t), row);
+        }
+        
+        switch (_type) {
+            case _USQL_ENUM_VALUE(ColumnType, Integer):
+                _ints.push_back(t == SQLITE_NULL ? 0 : sqlite3_column_int64(stmt, idx));
+                break;
+                
+            case _USQL_ENUM_VALUE(ColumnType, Float):
+                _floats.push_back(t == SQLITE_NULL ? 0.0 : sqlite3_column_double(stmt, idx));
+                break;
+                
+            case _USQL_ENUM_VALUE(ColumnType, Text):
+            case _USQL_ENUM_VALUE(ColumnType, Blob):
+                if (t != SQLITE_NULL) {
+                    const char *p = static_cast<const char *>(_type == _USQL_ENUM_VALUE(ColumnType, Text)
+                                                              ? static_cast<const void *>(sqlite3_column_text(stmt, idx))
+                                                              : sqlite3_column_blob(stmt, idx));
+                    int n = sqlite3_column_bytes(stmt, idx);
+                    if (p && n > 0) {
+                        _bytes.insert(_bytes.end(), p, p + n);
+                    }
+                }
+                _offsets.push_back(static_cast<uint32_t>(_bytes.size()));
+                break;
+                
+            default:
+                break;
+        }
+    }
+    
+#pragma mark - batch
+    int ColumnBatch::columnIndexForName(const std::string &name) const {
+        for (size_t i = 0; i < _columns.size(); ++i) {
+            if (_columns[i]._name == name) {
+                return static_cast<int>(i);
+            }
+        }
+        
+        return USQL_INVALID_COLUMN_INDEX;
+    }
+    
+    void ColumnBatch::setColumnType(int idx, ColumnType type) {
+        if (idx < 0 || idx >= columnCount() || _rowCount > 0) {
+            return;
+        }
+        
+        _columns[idx].setType(type, 0);
+    }
+    
+    void ColumnBatch::clear() {
+        for (auto iter = _columns.begin(); iter != _columns.end(); ++iter) {
+            iter->clear();
+        }
+        
+        _rowCount = 0;
+    }
+    
+    void ColumnBatch::init(sqlite3_stmt *stmt) {
+        //the same columns keep their types and buffers, another query starts from scratch
+        int count = sqlite3_column_count(stmt);
+        bool same = count == columnCount();
+        for (int i = 0; same && i < count; ++i) {
+            const char *name = sqlite3_column_name(stmt, i);
+            same = _columns[i]._name == (name ? name : "");
+        }
+        if (same) {
+            return;
+        }
+        
+        reset();
+        _columns.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            const char *name = sqlite3_column_name(stmt, i);
+            _columns.push_back(Column(name ? name : ""));
+        }
+    }
+    
+    void ColumnBatch::append(sqlite3_stmt *stmt) {
+        for (size_t i = 0; i < _columns.size(); ++i) {
+            _columns[i].append(stmt, static_cast<int>(i), _rowCount);
+        }
+        
+        ++_rowCount;
+    }
+}
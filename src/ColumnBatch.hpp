@@ -0,0 +1,172 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef ColumnBatch_hpp
+#define ColumnBatch_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "DataView.hpp"
+
+namespace usql {
+    //rows fetched column by column into contiguous buffers, see Query::fetch
+    //buffers are kept between batches, so reuse one ColumnBatch for a whole scan
+    class ColumnBatch : public NoCopyable
+    {
+    public:
+        class Column
+        {
+        public:
+            Column(const std::string &name) : _name(name), _type(_USQL_ENUM_VALUE(ColumnType, Null)) {}
+            
+            std::string name() const {
+                return _name;
+            }
+            
+            //Integer, Float, Text or Blob, decided by the first non-null value unless set by ColumnBatch::setColumnType
+            //Null while every value so far was null
+            ColumnType type() const {
+                return _type;
+            }
+            
+            bool isNull(size_t row) const {
+                return (_nulls[row >> 3] >> (row & 7)) & 1;
+            }
+            
+            //one bit per row, set when the value is null
+            const uint8_t *nulls() const {
+                return _nulls.data();
+            }
+            
+            //Integer column, null rows are 0
+            const int64_t *ints() const {
+                return _ints.data();
+            }
+            
+            //Float column, null rows are 0.0
+            const double *floats() const {
+                return _floats.data();
+            }
+            
+            //Text and Blob columns, value i is bytes()[offsets()[i], offsets()[i + 1])
+            const uint32_t *offsets() const {
+                return _offsets.data();
+            }
+            
+            const char *bytes() const {
+                return _bytes.data();
+            }
+            
+            //empty for a column that is neither Text nor Blob, isNull() only for a null row
+            TextView text(size_t row) const {
+                if (!hasBytes(row) || isNull(row)) {
+                    return TextView();
+                }
+                return TextView(bytesAt(row), _offsets[row + 1] - _offsets[row]);
+            }
+            
+            BlobView blob(size_t row) const {
+                if (!hasBytes(row) || isNull(row)) {
+                    return BlobView();
+                }
+                return BlobView(reinterpret_cast<const unsigned char *>(bytesAt(row)), _offsets[row + 1] - _offsets[row]);
+            }
+            
+        private:
+            friend class ColumnBatch;
+            
+            bool hasBytes(size_t row) const {
+                bool bytes = _type == _USQL_ENUM_VALUE(ColumnType, Text) || _type == _USQL_ENUM_VALUE(ColumnType, Blob);
+                assert(bytes && "usql: text or blob of a column that holds neither");
+                assert((!bytes || row + 1 < _offsets.size()) && "usql: column row out of range");
+                return bytes && row + 1 < _offsets.size();
+            }
+            
+            //an empty arena has no data(), empty values still need a non-null view
+            const char *bytesAt(size_t row) const {
+                return _bytes.empty() ? "" : _bytes.data() + _offsets[row];
+            }
+            
+            void clear();
+            void setType(ColumnType type, size_t rows);
+            void append(sqlite3_stmt *stmt, int idx, size_t row);
+            
+        private:
+            std::string _name;
+            ColumnType _type;
+            
+            std::vector<uint8_t> _nulls;
+            std::vector<int64_t> _ints;
+            std::vector<double> _floats;
+            std::vector<uint32_t> _offsets;
+            std::vector<char> _bytes;
+        };
+        
+    public:
+        ColumnBatch() : _rowCount(0) {}
+        
+        size_t rowCount() const {
+            return _rowCount;
+        }
+        
+        int columnCount() const {
+            return static_cast<int>(_columns.size());
+        }
+        
+        const Column &column(int idx) const {
+            return _columns[idx];
+        }
+        
+        int columnIndexForName(const std::string &name) const;
+        
+        //forces the storage of a column between batches, values are converted by sqlite
+        //Query::fetch(batch, 0) sets up the columns without stepping
+        void setColumnType(int idx, ColumnType type);
+        
+        //drops the rows but keeps columns, types and buffers
+        void clear();
+        
+        //drops everything, the next fetch starts from scratch
+        void reset() {
+            _columns.clear();
+            _rowCount = 0;
+        }
+        
+    private:
+        friend class Query;
+        
+        void init(sqlite3_stmt *stmt);
+        void append(sqlite3_stmt *stmt);
+        
+    private:
+        std::vector<Column> _columns;
+        size_t _rowCount;
+    };
+}
+
+#endif /* ColumnBatch_hpp */
@@ -27,11 +27,29 @@
 #include "Connection.hpp"
 #include "Query.hpp"
 #include "Cursor.hpp"
+#include "Transaction.hpp"
+#include "ArrayTable.hpp"
+#include <thread>
+
+#define USQL_SAVEPOINT_NAME "usql_savepoint"
 
 namespace usql {
     Connection::Connection(const std::string &fn)
     : _filename(fn.empty() ? ":memory" : fn)
-    , _db(Database::create()){
+    , _db(Database::create())
+    , _cache(StatementCache::create(_db))
+    , _savepointDepth(0) {
+    }
+    
+    Connection::TransactionStats::TransactionStats()
+    : commits(0)
+    , rollbacks(0)
+    , savepointReleases(0)
+    , savepointRollbacks(0)
+    , totalCommitMilliseconds(0)
+    , maxCommitMilliseconds(0)
+    , totalRollbackMilliseconds(0)
+    , maxRollbackMilliseconds(0) {
     }
     
     Connection::~Connection() {
@@ -43,12 +61,56 @@ namespace usql {
     }
     
     Result Connection::open(int flags) {
-        return Result(_db->open(_filename, flags), _db);
+        if (isOpenning()) {
+            return Result::success();
+        }
+        
+        Result ret(_db->open(_filename, flags), _db);
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+        //the table behind Cursor::bind of a std::vector
+        if (ret) {
+            ret = registerTable(ArrayTable::tableName(), _VirtualTable(new ArrayTable()));
+            if (!ret) {
+                _db->close();
+            }
+        }
+#endif
+        
+        return ret;
+    }
+    
+    Result Connection::open(OpenProfile profile) {
+        return open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, PragmaProfile::profile(profile));
+    }
+    
+    Result Connection::open(int flags, const PragmaProfile &profile) {
+        bool opened = isOpenning();
+        Result ret = opened ? Result::success() : open(flags);
+        if (!ret) {
+            return ret;
+        }
+        
+        std::vector<std::string> cmds = profile.commands();
+        for (auto iter = cmds.begin(); iter != cmds.end(); ++iter) {
+            ret = exec(*iter);
+            if (!ret) {
+                Result err(ret.code(), ret.description());
+                if (!opened) {
+                    close();
+                }
+                return err;
+            }
+        }
+        
+        return ret;
     }
     
     Result Connection::close() {
+        _cache->clear();
+        
         Result ret(_db->close(), _db);
         if (ret) {
+            _savepointDepth = 0;
 #if _USQL_SQLITE_CREATE_FUNCTION_V2_ENABLE
             _functions.clear();
 #endif
@@ -75,44 +137,105 @@ namespace usql {
             return false;
         }
         
-        std::stringstream ss;
-        ss<<"BEGIN ";
+        const char *cmd = "BEGIN EXCLUSIVE TRANSACTION";
         if (type == _USQL_ENUM_VALUE(TransactionType, Deferred)) {
-            ss<<"DEFERRED";
+            cmd = "BEGIN DEFERRED TRANSACTION";
         }
         else if(type == _USQL_ENUM_VALUE(TransactionType, Immediate)) {
-            ss<<"IMMEDIATE";
-        }
-        else {
-            ss<<"EXCLUSIVE";
+            cmd = "BEGIN IMMEDIATE TRANSACTION";
         }
-        ss<<" TRANSACTION";
         
-        return this->exec(ss.str());
+        return this->exec(cmd);
     }
     
     Result Connection::commit() {
-        return this->exec("COMMIT");
+        auto begin = std::chrono::steady_clock::now();
+        Result ret = this->exec("COMMIT");
+        if (ret) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            ++_transactionStats.commits;
+            _transactionStats.totalCommitMilliseconds += ms;
+            _transactionStats.maxCommitMilliseconds = std::max(_transactionStats.maxCommitMilliseconds, ms);
+            _savepointDepth = 0;
+        }
+        
+        return ret;
     }
     
     Result Connection::rollback() {
-        return this->exec("ROLLBACK");
+        auto begin = std::chrono::steady_clock::now();
+        Result ret = this->exec("ROLLBACK");
+        if (ret) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            ++_transactionStats.rollbacks;
+            _transactionStats.totalRollbackMilliseconds += ms;
+            _transactionStats.maxRollbackMilliseconds = std::max(_transactionStats.maxRollbackMilliseconds, ms);
+            _savepointDepth = 0;
+        }
+        
+        return ret;
     }
     
     Result Connection::transaction(TransactionType type, tr1::function<bool(Connection &)> action) {
-        Result ret = beginTransaction(type);
-        if (!ret) {
-            return ret;
+        Transaction trans(*this, type);
+        if (!trans.isActive()) {
+            return trans.beginResult();
         }
         
         if (action(*this)) {
-            return commit();
+            return trans.commit();
         }
         else {
-            return rollback();
+            return trans.rollback();
         }
     }
     
+    bool Connection::inTransaction() {
+        return isOpenning() && !sqlite3_get_autocommit(_db->db());
+    }
+    
+    Result Connection::savepoint() {
+        Result ret = this->exec("SAVEPOINT " USQL_SAVEPOINT_NAME);
+        if (ret) {
+            ++_savepointDepth;
+        }
+        
+        return ret;
+    }
+    
+    Result Connection::releaseSavepoint() {
+        if (_savepointDepth == 0) {
+            return Result::error();
+        }
+        
+        Result ret = this->exec("RELEASE " USQL_SAVEPOINT_NAME);
+        if (ret) {
+            --_savepointDepth;
+            ++_transactionStats.savepointReleases;
+        }
+        
+        return ret;
+    }
+    
+    Result Connection::rollbackToSavepoint() {
+        if (_savepointDepth == 0) {
+            return Result::error();
+        }
+        
+        Result ret = this->exec("ROLLBACK TO " USQL_SAVEPOINT_NAME);
+        if (!ret) {
+            return ret;
+        }
+        
+        ret = this->exec("RELEASE " USQL_SAVEPOINT_NAME);
+        if (ret) {
+            --_savepointDepth;
+            ++_transactionStats.savepointRollbacks;
+        }
+        
+        return ret;
+    }
+    
     bool Connection::tableExists(const std::string &tablename, const std::string &schema) {
         if (tablename.empty() || !isOpenning()) {
             return false;
@@ -123,8 +246,9 @@ namespace usql {
         if (!schema.empty()) {
             buf<<schema<<".";
         }
-        buf<<"sqlite_master WHERE type='table' AND name='"<<tablename<<"'";
+        buf<<"sqlite_master WHERE type='table' AND name=?";
         Query query(buf.str(), *this);
+        query.bind(1, tablename);
         if (!query.next()) {
             return false;
         }
@@ -224,48 +348,225 @@ namespace usql {
         return dbs;
     }
     
-#if _USQL_SQLITE_CREATE_FUNCTION_V2_ENABLE
-    Result Connection::registerFunction(Function *func) {
-        int opt = 0;
+    Connection::BackupProgress::BackupProgress()
+    : remaining(0)
+    , pageCount(0)
+    , pagesCopied(0)
+    , steps(0)
+    , milliseconds(0) {
+    }
+    
+    Connection::BackupOptions::BackupOptions()
+    : pagesPerStep(USQL_DEFAULT_BACKUP_PAGES_PER_STEP)
+    , stepInterval(USQL_DEFAULT_BACKUP_STEP_INTERVAL)
+    , busyTimeout(USQL_DEFAULT_BACKUP_BUSY_TIMEOUT)
+    , schema("main") {
+    }
+    
+    static Result backupDatabase(_Database dest, _Database source, const Connection::BackupOptions &options) {
+        if (!dest->isOpening() || !source->isOpening()) {
+            return false;
+        }
+        
+        std::string schema = options.schema.empty() ? "main" : options.schema;
+        sqlite3_backup *backup = sqlite3_backup_init(dest->db(), schema.c_str(), source->db(), schema.c_str());
+        if (!backup) {
+            return Result(sqlite3_errcode(dest->db()), dest);
+        }
+        
+        Connection::BackupProgress progress;
+        auto begin = std::chrono::steady_clock::now();
         int code = SQLITE_OK;
+        bool cancelled = false;
+        bool busy = false;
+        //the deadline only runs while no step gets through
+        auto busySince = begin;
+        while (true) {
+            code = sqlite3_backup_step(backup, options.pagesPerStep);
+            ++progress.steps;
+            progress.remaining = sqlite3_backup_remaining(backup);
+            progress.pageCount = sqlite3_backup_pagecount(backup);
+            progress.pagesCopied = progress.pageCount - progress.remaining;
+            progress.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            
+            if (code != SQLITE_OK && code != SQLITE_BUSY && code != SQLITE_LOCKED) {
+                break;
+            }
+            
+            if (options.progress && !options.progress(progress)) {
+                cancelled = true;
+                break;
+            }
+            
+            bool locked = code == SQLITE_BUSY || code == SQLITE_LOCKED;
+            if (locked) {
+                auto now = std::chrono::steady_clock::now();
+                if (!busy) {
+                    busy = true;
+                    busySince = now;
+                }
+                else if (now - busySince >= std::chrono::milliseconds(std::max(0, options.busyTimeout))) {
+                    code = SQLITE_BUSY;
+                    break;
+                }
+            }
+            else {
+                busy = false;
+            }
+            
+            if (options.stepInterval > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.stepInterval));
+            }
+            else if (locked) {
+                //the lock is held by someone else, spinning would not release it sooner
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        
+        if (code == SQLITE_DONE && options.progress) {
+            options.progress(progress);
+        }
+        
+        int ret = sqlite3_backup_finish(backup);
+        if (cancelled) {
+            return Result(SQLITE_ABORT, _USQL_SQLITE_ERRSTR(SQLITE_ABORT));
+        }
+        
+        if (code == SQLITE_BUSY) {
+            return Result(SQLITE_BUSY, _USQL_SQLITE_ERRSTR(SQLITE_BUSY));
+        }
+        
+        if (code != SQLITE_DONE) {
+            return Result(code, dest);
+        }
+        
+        return Result(ret, dest);
+    }
+    
+    Result Connection::backupTo(Connection &dest, const BackupOptions &options) {
+        return backupDatabase(dest._db, _db, options);
+    }
+    
+    Result Connection::backupTo(const std::string &filename, const BackupOptions &options) {
+        Connection dest(filename);
+        Result ret = dest.open();
+        if (!ret) {
+            return ret;
+        }
+        
+        ret = backupTo(dest, options);
+        if (!ret) {
+            Result err(ret.code(), ret.description());
+            dest.close();
+            return err;
+        }
         
-        typedef void(*sqlite_func)(sqlite3_context*,int,sqlite3_value**);
-        sqlite_func xfunc = nullptr, xstep = nullptr;
-        void (*xfinal)(sqlite3_context *) = nullptr;
+        return dest.close();
+    }
+    
+    Result Connection::restoreFrom(Connection &source, const BackupOptions &options) {
+        return backupDatabase(_db, source._db, options);
+    }
+    
+    Result Connection::restoreFrom(const std::string &filename, const BackupOptions &options) {
+        Connection source(filename);
+        Result ret = source.open(SQLITE_OPEN_READONLY);
+        if (!ret) {
+            return ret;
+        }
         
-        if (!func || !isOpenning()) {
-            goto failed;
+        ret = restoreFrom(source, options);
+        if (!ret) {
+            Result err(ret.code(), ret.description());
+            source.close();
+            return err;
         }
         
-        if (func->name.empty()) {
-            goto failed;
+        return source.close();
+    }
+    
+#if _USQL_SQLITE_CREATE_FUNCTION_V2_ENABLE
+    Result Connection::registerFunction(Function *func) {
+        if (!func) {
+            return false;
         }
         
-        opt |= static_cast<int>(func->encoding);
+        int opt = static_cast<int>(func->encoding);
         if (func->deterministic) {
             opt |= SQLITE_DETERMINISTIC;
         }
         
+#if _USQL_SQLITE_WINDOW_FUNCTION_ENABLE
+        if (dynamic_cast<WindowFunction *>(func)) {
+            return createWindowFunction(func->name, func->argumentCount(), opt, func, Function::xFunc, AggregateFunction::xFinal, WindowFunction::xValue, WindowFunction::xInverse, Function::xDestroy);
+        }
+#endif
+        
         if (dynamic_cast<AggregateFunction *>(func)) {
-            xstep = Function::xFunc;
-            xfinal = AggregateFunction::xFinal;
+            return createFunction(func->name, func->argumentCount(), opt, func, nullptr, Function::xFunc, AggregateFunction::xFinal, Function::xDestroy);
         }
-        else {
-            xfunc = Function::xFunc;
+        
+        return createFunction(func->name, func->argumentCount(), opt, func, Function::xFunc, nullptr, nullptr, Function::xDestroy);
+    }
+    
+    Result Connection::createFunction(const std::string &name, int argc, int flags, void *data,
+                                      void (*xFunc)(sqlite3_context *, int, sqlite3_value **),
+                                      void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+                                      void (*xFinal)(sqlite3_context *),
+                                      void (*xDestroy)(void *)) {
+        if (name.empty() || !isOpenning()) {
+            if (xDestroy) {
+                xDestroy(data);
+            }
+            return false;
         }
         
-        code = sqlite3_create_function_v2(_db->db(), func->name.c_str(), func->argumentCount(), opt, func, xfunc, xstep, xfinal, Function::xDestroy);
-        if (!_USQL_OK(code)) {
-            delete func;
-            return Result(code, _db);
+        //sqlite calls xDestroy itself when the registration fails
+        int code = sqlite3_create_function_v2(_db->db(), name.c_str(), argc, flags, data, xFunc, xStep, xFinal, xDestroy);
+        if (_USQL_OK(code)) {
+            addRegisteredFunction(name, argc, flags);
         }
         
-        _functions.push_back(func->name);
         return Result(code, _db);
+    }
+    
+#if _USQL_SQLITE_WINDOW_FUNCTION_ENABLE
+    Result Connection::createWindowFunction(const std::string &name, int argc, int flags, void *data,
+                                            void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+                                            void (*xFinal)(sqlite3_context *),
+                                            void (*xValue)(sqlite3_context *),
+                                            void (*xInverse)(sqlite3_context *, int, sqlite3_value **),
+                                            void (*xDestroy)(void *)) {
+        if (name.empty() || !isOpenning()) {
+            if (xDestroy) {
+                xDestroy(data);
+            }
+            return false;
+        }
         
-    failed:
-        delete func;
-        return false;
+        int code = sqlite3_create_window_function(_db->db(), name.c_str(), argc, flags, data, xStep, xFinal, xValue, xInverse, xDestroy);
+        if (_USQL_OK(code)) {
+            addRegisteredFunction(name, argc, flags);
+        }
+        
+        return Result(code, _db);
+    }
+#endif
+    
+    void Connection::addRegisteredFunction(const std::string &name, int argc, int flags) {
+        int encoding = flags & (SQLITE_UTF8 | SQLITE_UTF16LE | SQLITE_UTF16BE | SQLITE_UTF16);
+        for (auto iter = _functions.begin(); iter != _functions.end(); ) {
+            if (iter->name == name && iter->argc == argc && iter->encoding == encoding) {
+                iter = _functions.erase(iter);
+            }
+            else {
+                ++iter;
+            }
+        }
+        _functions.push_back(RegisteredFunction(name, argc, encoding));
     }
     
     void Connection::unregisterFunction(const std::string name) {
@@ -273,15 +574,46 @@ namespace usql {
             return;
         }
         
-        sqlite3_create_function(_db->db(), name.c_str(), -1, 0, nullptr, nullptr, nullptr, nullptr);
-        _functions.remove(name);
+        for (auto iter = _functions.begin(); iter != _functions.end(); ) {
+            if (iter->name == name) {
+                sqlite3_create_function(_db->db(), name.c_str(), iter->argc, iter->encoding, nullptr, nullptr, nullptr, nullptr);
+                iter = _functions.erase(iter);
+            }
+            else {
+                ++iter;
+            }
+        }
     }
     
     void Connection::unregisterAllFunctions() {
+        if (!isOpenning()) {
+            return;
+        }
+        
         for (auto iter = _functions.begin(); iter != _functions.end(); ++iter) {
-            sqlite3_create_function(_db->db(), iter->c_str(), -1, 0, nullptr, nullptr, nullptr, nullptr);
+            sqlite3_create_function(_db->db(), iter->name.c_str(), iter->argc, iter->encoding, nullptr, nullptr, nullptr, nullptr);
         }
         _functions.clear();
     }
 #endif
-}
\ No newline at end of file
+    
+    Result Connection::registerTable(const std::string &name, const _VirtualTable &table) {
+        if (name.empty() || !table || !isOpenning()) {
+            return false;
+        }
+        
+        //cached statements may still use a table registered under the same name
+        _cache->clear();
+        int code = sqlite3_create_module_v2(_db->db(), name.c_str(), VirtualTable::module(), new _VirtualTable(table), VirtualTable::xDestroy);
+        return Result(code, _db);
+    }
+    
+    void Connection::unregisterTable(const std::string &name) {
+        if (!isOpenning()) {
+            return;
+        }
+        
+        _cache->clear();
+        sqlite3_create_module_v2(_db->db(), name.c_str(), nullptr, nullptr, nullptr);
+    }
+}
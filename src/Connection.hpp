@@ -29,8 +29,12 @@
 
 #include "StdCpp.hpp"
 #include "Database.hpp"
+#include "StatementCache.hpp"
 #include "Result.hpp"
 #include "Function.hpp"
+#include "PragmaProfile.hpp"
+#include "VirtualTable.hpp"
+#include <chrono>
 
 namespace usql {
     class Connection : public NoCopyable
@@ -41,24 +45,133 @@ namespace usql {
         
         Result open();
         Result open(int flags);
+        //applies the profile's pragmas before returning, the connection is closed again if one fails;
+        //an open connection keeps its flags and stays open, the pragmas are applied to it
+        Result open(OpenProfile profile);
+        Result open(int flags, const PragmaProfile &profile);
         bool isOpenning() const {
             return _db->isOpening();
         }
         
         Result close();
         
+        std::string filename() const {
+            return _filename;
+        }
+        
         _WeakDatabase database() {
             return _db;
         }
         
+        _WeakStatementCache statementCache() {
+            return _cache;
+        }
+        
+        //statement cache
+        void setStatementCacheCapacity(size_t capacity) {
+            _cache->setCapacity(capacity);
+        }
+        
+        size_t statementCacheCapacity() const {
+            return _cache->capacity();
+        }
+        
+        size_t statementCacheSize() const {
+            return _cache->size();
+        }
+        
+        uint64_t statementCacheHits() const {
+            return _cache->hits();
+        }
+        
+        uint64_t statementCacheMisses() const {
+            return _cache->misses();
+        }
+        
+        //retries of a locked database, e.g. BusyPolicy::backoff(1000)
+        void setBusyPolicy(const BusyPolicy &policy) {
+            _db->setBusyPolicy(policy);
+        }
+        
+        const BusyPolicy &busyPolicy() const {
+            return _db->busyPolicy();
+        }
+        
+        const BusyStats &busyStats() const {
+            return _db->busyStats();
+        }
+        
+        void resetBusyStats() {
+            _db->resetBusyStats();
+        }
+        
+        //per sql latency, rows and stmt_status counters plus a slow query log, kept across close and open;
+        //the profiler is filled on this connection's thread and can be read from any other
+        _Profiler enableProfiling(const ProfilerOptions &options = ProfilerOptions()) {
+            _Profiler profiler = Profiler::create(options);
+            _db->setProfiler(profiler);
+            return profiler;
+        }
+        
+        void disableProfiling() {
+            _db->setProfiler(_Profiler());
+        }
+        
+        _Profiler profiler() const {
+            return _db->profiler();
+        }
+        
     public:
         Result exec(const std::string &cmd);
         
+        //rowid of the last successful INSERT on this connection, 0 if there was none
+        sqlite3_int64 lastInsertRowId() {
+            return isOpenning() ? sqlite3_last_insert_rowid(_db->db()) : 0;
+        }
+        
         Result beginTransaction(TransactionType type);
         Result commit();
         Result rollback();
+        //nests inside an open transaction through a savepoint, see Transaction
         Result transaction(TransactionType type, tr1::function<bool(Connection &)> action);
         
+        //false in autocommit mode
+        bool inTransaction();
+        
+        //savepoints share one name, so they must be released or rolled back in reverse order
+        Result savepoint();
+        Result releaseSavepoint();
+        //undoes the changes since the savepoint and releases it
+        Result rollbackToSavepoint();
+        
+        size_t savepointDepth() const {
+            return _savepointDepth;
+        }
+        
+        struct TransactionStats
+        {
+            uint64_t commits;
+            uint64_t rollbacks;
+            uint64_t savepointReleases;
+            uint64_t savepointRollbacks;
+            
+            //COMMIT and ROLLBACK latency, savepoints are not timed
+            double totalCommitMilliseconds;
+            double maxCommitMilliseconds;
+            double totalRollbackMilliseconds;
+            double maxRollbackMilliseconds;
+            
+            TransactionStats();
+        };
+        
+        const TransactionStats &transactionStats() const {
+            return _transactionStats;
+        }
+        
+        void resetTransactionStats() {
+            _transactionStats = TransactionStats();
+        }
+        
         //tables
         struct ColumnInfo
         {
@@ -93,20 +206,126 @@ namespace usql {
         void detachDatabase(const std::string &schema);
         std::vector<DatabaseInfo> allDatabase();
         
+        //online backup
+        struct BackupProgress
+        {
+            int remaining;
+            int pageCount;
+            int pagesCopied;
+            int steps;
+            double milliseconds;
+            
+            double pagesPerSecond() const {
+                return milliseconds > 0 ? pagesCopied * 1000.0 / milliseconds : 0;
+            }
+            
+            BackupProgress();
+        };
+        
+        struct BackupOptions
+        {
+            //pages copied per step, negative copies everything in one step
+            int pagesPerStep;
+            //pause between steps so writers can take the source, 0 only yields
+            int stepInterval;
+            //milliseconds a locked source or destination is retried without progress, then SQLITE_BUSY
+            int busyTimeout;
+            std::string schema;
+            //called after every step, returning false cancels the backup
+            tr1::function<bool(const BackupProgress &)> progress;
+            
+            BackupOptions();
+        };
+        
+        //copies the database page by page and overwrites the destination; the source is only
+        //locked during a step, a write from another connection restarts the copy
+        Result backupTo(Connection &dest, const BackupOptions &options = BackupOptions());
+        Result backupTo(const std::string &filename, const BackupOptions &options = BackupOptions());
+        //e.g. a ":memory:" read replica restored from the file it serves
+        Result restoreFrom(Connection &source, const BackupOptions &options = BackupOptions());
+        Result restoreFrom(const std::string &filename, const BackupOptions &options = BackupOptions());
+        
     public:
 #if _USQL_SQLITE_CREATE_FUNCTION_V2_ENABLE
         Result registerFunction(Function *func);
         
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+        //arguments are decoded and the result is set from the signature, a call allocates nothing;
+        //e.g. registerScalar<double(double, double)>("usql_mul", [](double a, double b) { return a * b; })
+        template<class Signature, class F>
+        Result registerScalar(const std::string &name, const F &func, bool deterministic = false) {
+            typedef TypedFunction<F, Signature> Scalar;
+            int flags = SQLITE_UTF8 | (deterministic ? SQLITE_DETERMINISTIC : 0);
+            return createFunction(name, Scalar::argumentCount(), flags, new Scalar(func), &Scalar::xFunc, nullptr, nullptr, &Scalar::xDestroy);
+        }
+        
+        //every group starts from a copy of prototype inside sqlite3_aggregate_context, see TypedAggregate;
+        //e.g. registerAggregate<Average>("usql_avg") with void Average::step(double) and double Average::value()
+        template<class State>
+        Result registerAggregate(const std::string &name, const State &prototype = State(), bool deterministic = false) {
+            typedef TypedAggregate<State> Aggregate;
+            int flags = SQLITE_UTF8 | (deterministic ? SQLITE_DETERMINISTIC : 0);
+            return createFunction(name, Aggregate::argumentCount(), flags, new Aggregate(prototype), nullptr, &Aggregate::xStep, &Aggregate::xFinal, &Aggregate::xDestroy);
+        }
+        
+#if _USQL_SQLITE_WINDOW_FUNCTION_ENABLE
+        //registerAggregate that also slides over window frames, State::inverse(args...) takes back a row
+        template<class State>
+        Result registerWindow(const std::string &name, const State &prototype = State(), bool deterministic = false) {
+            typedef TypedAggregate<State> Aggregate;
+            int flags = SQLITE_UTF8 | (deterministic ? SQLITE_DETERMINISTIC : 0);
+            return createWindowFunction(name, Aggregate::argumentCount(), flags, new Aggregate(prototype), &Aggregate::xStep, &Aggregate::xFinal, &Aggregate::xValue, &Aggregate::xInverse, &Aggregate::xDestroy);
+        }
+#endif
+#endif
+        
         void unregisterFunction(const std::string name);
         void unregisterAllFunctions();
 #endif
         
+        //serves table as the eponymous virtual table name, "select * from name" reads it in place;
+        //the registration ends with unregisterTable or close
+        Result registerTable(const std::string &name, const _VirtualTable &table);
+        void unregisterTable(const std::string &name);
+        
+#if _USQL_SQLITE_CREATE_FUNCTION_V2_ENABLE
+    private:
+        //takes ownership of data, xDestroy releases it also when the registration fails
+        Result createFunction(const std::string &name, int argc, int flags, void *data,
+                              void (*xFunc)(sqlite3_context *, int, sqlite3_value **),
+                              void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+                              void (*xFinal)(sqlite3_context *),
+                              void (*xDestroy)(void *));
+#if _USQL_SQLITE_WINDOW_FUNCTION_ENABLE
+        Result createWindowFunction(const std::string &name, int argc, int flags, void *data,
+                                    void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+                                    void (*xFinal)(sqlite3_context *),
+                                    void (*xValue)(sqlite3_context *),
+                                    void (*xInverse)(sqlite3_context *, int, sqlite3_value **),
+                                    void (*xDestroy)(void *));
+#endif
+        void addRegisteredFunction(const std::string &name, int argc, int flags);
+#endif
+        
     private:
         std::string _filename;
         _Database _db;
+        _StatementCache _cache;
+        
+        size_t _savepointDepth;
+        TransactionStats _transactionStats;
         
 #if _USQL_SQLITE_CREATE_FUNCTION_V2_ENABLE
-        std::list<std::string> _functions;
+        //sqlite finds a function by name, argument count and encoding
+        struct RegisteredFunction
+        {
+            std::string name;
+            int argc;
+            int encoding;
+            
+            RegisteredFunction(const std::string &n, int a, int e) : name(n), argc(a), encoding(e) {}
+        };
+        std::list<RegisteredFunction> _functions;
 #endif
     };
 }
@@ -0,0 +1,289 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "ConnectionPool.hpp"
+#include "Connection.hpp"
+
+namespace usql {
+    ConnectionPool::Lease::Lease(ConnectionPool *pool, Connection *con, bool writer)
+    : _pool(pool)
+    , _connection(con)
+    , _writer(writer)
+    , _acquired(std::chrono::steady_clock::now()) {
+    }
+    
+    ConnectionPool::Lease::Lease(Lease &&other)
+    : _pool(other._pool)
+    , _connection(other._connection)
+    , _writer(other._writer)
+    , _acquired(other._acquired) {
+        other._pool = nullptr;
+        other._connection = nullptr;
+    }
+    
+    ConnectionPool::Lease &ConnectionPool::Lease::operator=(Lease &&other) {
+        if (this == &other) {
+            return *this;
+        }
+        
+        release();
+        _pool = other._pool;
+        _connection = other._connection;
+        _writer = other._writer;
+        _acquired = other._acquired;
+        other._pool = nullptr;
+        other._connection = nullptr;
+        return *this;
+    }
+    
+    void ConnectionPool::Lease::release() {
+        if (!_pool || !_connection) {
+            return;
+        }
+        
+        _pool->release(_connection, _writer, std::chrono::steady_clock::now() - _acquired);
+        _pool = nullptr;
+        _connection = nullptr;
+    }
+    
+    ConnectionPool::Stats::Stats()
+    : readers(0)
+    , readersInUse(0)
+    , peakReadersInUse(0)
+    , writerInUse(false)
+    , readerLeases(0)
+    , writerLeases(0)
+    , waits(0)
+    , timeouts(0)
+    , totalWaitMilliseconds(0)
+    , maxWaitMilliseconds(0)
+    , readerUtilisation(0)
+    , writerUtilisation(0) {
+    }
+    
+    ConnectionPool::ConnectionPool(const std::string &filename, size_t readers)
+    : _filename(filename)
+    , _readerCount(std::max<size_t>(1, readers))
+    , _writer(nullptr)
+    , _writerIdle(false)
+    , _leases(0)
+    , _readerHeld(Clock::duration::zero())
+    , _writerHeld(Clock::duration::zero())
+    , _totalWait(Clock::duration::zero())
+    , _maxWait(Clock::duration::zero()) {
+    }
+    
+    ConnectionPool::~ConnectionPool() {
+        assert(_leases == 0);
+        close();
+    }
+    
+    Result ConnectionPool::open() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_writer) {
+            return Result::success();
+        }
+        
+        //wal needs a file shared by every connection
+        if (_filename.empty() || _filename == ":memory:") {
+            return Result::error();
+        }
+        
+        Connection *writer = new Connection(_filename);
+        Result ret = writer->open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX);
+        if (ret) {
+            ret = writer->exec("PRAGMA journal_mode=WAL");
+        }
+        
+        if (!ret) {
+            delete writer;
+            return ret;
+        }
+        
+        std::vector<Connection *> readers;
+        for (size_t i = 0; i < _readerCount; ++i) {
+            Connection *reader = new Connection(_filename);
+            readers.push_back(reader);
+            ret = reader->open(SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX);
+            if (!ret) {
+                break;
+            }
+        }
+        
+        if (!ret) {
+            for (auto iter = readers.begin(); iter != readers.end(); ++iter) {
+                delete *iter;
+            }
+            delete writer;
+            return ret;
+        }
+        
+        _writer = writer;
+        _writerIdle = true;
+        _readers = readers;
+        _idleReaders = readers;
+        
+        _stats = Stats();
+        _statsBegin = Clock::now();
+        _readerHeld = _writerHeld = _totalWait = _maxWait = Clock::duration::zero();
+        return ret;
+    }
+    
+    Result ConnectionPool::close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_writer) {
+            return Result::success();
+        }
+        
+        if (_leases > 0) {
+            return Result(SQLITE_BUSY, _USQL_SQLITE_ERRSTR(SQLITE_BUSY));
+        }
+        
+        for (auto iter = _readers.begin(); iter != _readers.end(); ++iter) {
+            delete *iter;
+        }
+        _readers.clear();
+        _idleReaders.clear();
+        
+        delete _writer;
+        _writer = nullptr;
+        _writerIdle = false;
+        return Result::success();
+    }
+    
+    bool ConnectionPool::isOpenning() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _writer != nullptr;
+    }
+    
+    ConnectionPool::Lease ConnectionPool::reader(int timeout) {
+        Connection *con = acquire(false, timeout);
+        return con ? Lease(this, con, false) : Lease();
+    }
+    
+    ConnectionPool::Lease ConnectionPool::writer(int timeout) {
+        Connection *con = acquire(true, timeout);
+        return con ? Lease(this, con, true) : Lease();
+    }
+    
+    Connection *ConnectionPool::acquire(bool writer, int timeout) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_writer) {
+            return nullptr;
+        }
+        
+        Clock::time_point begin = Clock::now();
+        std::condition_variable &available = writer ? _writerAvailable : _readerAvailable;
+        bool waited = false;
+        while (_writer && (writer ? !_writerIdle : _idleReaders.empty())) {
+            waited = true;
+            if (available.wait_until(lock, begin + std::chrono::milliseconds(std::max(0, timeout))) == std::cv_status::timeout) {
+                break;
+            }
+        }
+        
+        Clock::duration wait = Clock::now() - begin;
+        if (waited) {
+            ++_stats.waits;
+            _totalWait += wait;
+            _maxWait = std::max(_maxWait, wait);
+        }
+        
+        if (!_writer || (writer ? !_writerIdle : _idleReaders.empty())) {
+            ++_stats.timeouts;
+            return nullptr;
+        }
+        
+        Connection *con = nullptr;
+        if (writer) {
+            con = _writer;
+            _writerIdle = false;
+            ++_stats.writerLeases;
+        }
+        else {
+            con = _idleReaders.back();
+            _idleReaders.pop_back();
+            ++_stats.readerLeases;
+            _stats.peakReadersInUse = std::max(_stats.peakReadersInUse, _readers.size() - _idleReaders.size());
+        }
+        
+        ++_leases;
+        return con;
+    }
+    
+    void ConnectionPool::release(Connection *con, bool writer, Clock::duration held) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (writer) {
+                _writerIdle = true;
+                _writerHeld += held;
+            }
+            else {
+                _idleReaders.push_back(con);
+                _readerHeld += held;
+            }
+            
+            --_leases;
+        }
+        
+        if (writer) {
+            _writerAvailable.notify_one();
+        }
+        else {
+            _readerAvailable.notify_one();
+        }
+    }
+    
+    ConnectionPool::Stats ConnectionPool::stats() const {
+        typedef std::chrono::duration<double, std::milli> Milliseconds;
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        Stats stats = _stats;
+        stats.readers = _readers.size();
+        stats.readersInUse = _readers.size() - _idleReaders.size();
+        stats.writerInUse = _writer && !_writerIdle;
+        stats.totalWaitMilliseconds = Milliseconds(_totalWait).count();
+        stats.maxWaitMilliseconds = Milliseconds(_maxWait).count();
+        
+        double elapsed = Milliseconds(Clock::now() - _statsBegin).count();
+        if (elapsed > 0) {
+            if (!_readers.empty()) {
+                stats.readerUtilisation = std::min(1.0, Milliseconds(_readerHeld).count() / (elapsed * _readers.size()));
+            }
+            stats.writerUtilisation = std::min(1.0, Milliseconds(_writerHeld).count() / elapsed);
+        }
+        
+        return stats;
+    }
+    
+    void ConnectionPool::resetStats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats = Stats();
+        _statsBegin = Clock::now();
+        _readerHeld = _writerHeld = _totalWait = _maxWait = Clock::duration::zero();
+    }
+}
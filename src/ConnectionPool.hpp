@@ -0,0 +1,170 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef ConnectionPool_hpp
+#define ConnectionPool_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Result.hpp"
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+namespace usql {
+    class Connection;
+    class ConnectionPool;
+    
+    //one writer and N read-only connections to the same file in WAL mode,
+    //each connection is opened with SQLITE_OPEN_NOMUTEX and used by one thread at a time through a lease
+    class ConnectionPool : public NoCopyable
+    {
+    public:
+        //returns the connection to the pool when destroyed
+        class Lease
+        {
+        public:
+            Lease() : _pool(nullptr), _connection(nullptr), _writer(false) {}
+            Lease(Lease &&other);
+            Lease &operator=(Lease &&other);
+            ~Lease() {
+                release();
+            }
+            
+            bool valid() const {
+                return _connection != nullptr;
+            }
+            
+            operator bool() const {
+                return valid();
+            }
+            
+            bool isWriter() const {
+                return _writer;
+            }
+            
+            Connection &operator*() const {
+                assert(_connection);
+                return *_connection;
+            }
+            
+            Connection *operator->() const {
+                assert(_connection);
+                return _connection;
+            }
+            
+            void release();
+            
+        private:
+            friend class ConnectionPool;
+            Lease(ConnectionPool *pool, Connection *con, bool writer);
+            
+            Lease(const Lease &other);
+            Lease &operator=(const Lease &other);
+            
+        private:
+            ConnectionPool *_pool;
+            Connection *_connection;
+            bool _writer;
+            std::chrono::steady_clock::time_point _acquired;
+        };
+        
+        struct Stats
+        {
+            size_t readers;
+            size_t readersInUse;
+            size_t peakReadersInUse;
+            bool writerInUse;
+            
+            uint64_t readerLeases;
+            uint64_t writerLeases;
+            //leases that had to wait for a free connection
+            uint64_t waits;
+            uint64_t timeouts;
+            double totalWaitMilliseconds;
+            double maxWaitMilliseconds;
+            
+            //share of the time since open() or resetStats() the connections were leased, 0.0 ~ 1.0
+            double readerUtilisation;
+            double writerUtilisation;
+            
+            Stats();
+        };
+        
+    public:
+        ConnectionPool(const std::string &filename, size_t readers = USQL_DEFAULT_POOL_READERS);
+        virtual ~ConnectionPool();
+        
+        //opens the writer, switches the file to WAL and opens the readers
+        Result open();
+        //fails while leases are outstanding
+        Result close();
+        
+        bool isOpenning() const;
+        
+        size_t readerCount() const {
+            return _readerCount;
+        }
+        
+        //waits up to timeout milliseconds for a free connection, the lease is invalid on timeout
+        Lease reader(int timeout = USQL_DEFAULT_POOL_TIMEOUT);
+        Lease writer(int timeout = USQL_DEFAULT_POOL_TIMEOUT);
+        
+        Stats stats() const;
+        void resetStats();
+        
+    private:
+        Connection *acquire(bool writer, int timeout);
+        void release(Connection *con, bool writer, std::chrono::steady_clock::duration held);
+        
+    private:
+        typedef std::chrono::steady_clock Clock;
+        
+        std::string _filename;
+        size_t _readerCount;
+        
+        Connection *_writer;
+        std::vector<Connection *> _readers;
+        
+        mutable std::mutex _mutex;
+        std::condition_variable _readerAvailable;
+        std::condition_variable _writerAvailable;
+        std::vector<Connection *> _idleReaders;
+        bool _writerIdle;
+        size_t _leases;
+        
+        Stats _stats;
+        Clock::time_point _statsBegin;
+        Clock::duration _readerHeld;
+        Clock::duration _writerHeld;
+        Clock::duration _totalWait;
+        Clock::duration _maxWait;
+    };
+}
+
+#endif /* ConnectionPool_hpp */
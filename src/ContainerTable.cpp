@@ -0,0 +1,318 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "ContainerTable.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace usql {
+    namespace {
+        //bestIndex keeps the column in the low bits of idxNum and the bound arguments above
+        enum {
+            EqualArgument = 1 << 16,
+            LowerArgument = 1 << 17,
+            LowerStrict = 1 << 18,
+            UpperArgument = 1 << 19,
+            UpperStrict = 1 << 20,
+            ColumnMask = 0xffff
+        };
+        
+        bool binaryCollation(sqlite3_index_info *info, int i) {
+#if SQLITE_VERSION_NUMBER >= 3022000
+            const char *collation = sqlite3_vtab_collation(info, i);
+            return !collation || sqlite3_stricmp(collation, "BINARY") == 0;
+#else
+            return true;
+#endif
+        }
+    }
+    
+    class IndexedTable::Cursor : public VirtualTableCursor
+    {
+    public:
+        Cursor(IndexedTable *table) : _table(table), _pos(0), _end(0) {}
+        
+        virtual int filter(int idxNum, const char *, const FunctionArguments &argv) {
+            _order.reset();
+            _pos = 0;
+            _end = _table->rowCount();
+            
+            int column = (idxNum & ColumnMask) - 1;
+            if (column < 0 || column >= static_cast<int>(_table->columnCount())) {
+                return SQLITE_OK;
+            }
+            
+            _order = _table->order(column);
+            
+            //a bound that can not be compared, e.g. a text against an integer column, is not
+            //narrowed; sqlite still filters the rows
+            size_t arg = 0;
+            size_t lower = 0;
+            size_t upper = _end;
+            if (idxNum & EqualArgument) {
+                sqlite3_value *value = argv[arg++];
+                size_t first = 0;
+                size_t last = _end;
+                if (bound(column, value, false, first) && bound(column, value, true, last)) {
+                    lower = first;
+                    upper = last;
+                }
+            }
+            
+            if (idxNum & LowerArgument) {
+                size_t pos = 0;
+                if (bound(column, argv[arg++], (idxNum & LowerStrict) != 0, pos)) {
+                    lower = std::max(lower, pos);
+                }
+            }
+            
+            if (idxNum & UpperArgument) {
+                size_t pos = _end;
+                if (bound(column, argv[arg++], (idxNum & UpperStrict) == 0, pos)) {
+                    upper = std::min(upper, pos);
+                }
+            }
+            
+            _pos = lower;
+            _end = std::max(lower, upper);
+            return SQLITE_OK;
+        }
+        
+        virtual int next() {
+            ++_pos;
+            return SQLITE_OK;
+        }
+        
+        virtual bool eof() const {
+            return _pos >= _end;
+        }
+        
+        virtual int column(sqlite3_context *context, int column) {
+            _table->result(context, row(_pos), column);
+            return SQLITE_OK;
+        }
+        
+        virtual sqlite3_int64 rowid() const {
+            return static_cast<sqlite3_int64>(row(_pos));
+        }
+        
+    private:
+        size_t row(size_t pos) const {
+            return _order ? (*_order)[pos] : pos;
+        }
+        
+        //first position whose row is not below value, or above it when after is set
+        bool bound(int column, sqlite3_value *value, bool after, size_t &pos) const {
+            size_t lo = 0;
+            size_t hi = _order ? _order->size() : _table->rowCount();
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                int order = 0;
+                if (!_table->compare(row(mid), column, value, order)) {
+                    return false;
+                }
+                
+                if (order < 0 || (after && order == 0)) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            
+            pos = lo;
+            return true;
+        }
+        
+        IndexedTable *_table;
+        _RowOrder _order;
+        size_t _pos;
+        size_t _end;
+    };
+    
+    std::string IndexedTable::declaration() const {
+        std::string sql = "create table x(";
+        for (size_t i = 0; i < _columns.size(); ++i) {
+            if (i > 0) {
+                sql += ", ";
+            }
+            
+            sql += "\"";
+            for (size_t c = 0; c < _columns[i].name.size(); ++c) {
+                char ch = _columns[i].name[c];
+                sql += ch == '"' ? "\"\"" : std::string(1, ch);
+            }
+            sql += "\" " + _columns[i].type;
+        }
+        sql += ")";
+        return sql;
+    }
+    
+    int IndexedTable::bestIndex(sqlite3_index_info *info) {
+        double rows = static_cast<double>(rowCount());
+        int bestColumn = -1;
+        int bestEqual = -1;
+        int bestLower = -1;
+        int bestUpper = -1;
+        double bestRows = rows;
+        
+        for (int column = 0; column < static_cast<int>(_columns.size()); ++column) {
+            if (_columns[column].index == _USQL_ENUM_VALUE(TableIndex, NotIndexed)) {
+                continue;
+            }
+            
+            int equal = -1;
+            int lower = -1;
+            int upper = -1;
+            for (int i = 0; i < info->nConstraint; ++i) {
+                const sqlite3_index_info::sqlite3_index_constraint &constraint = info->aConstraint[i];
+                if (!constraint.usable || constraint.iColumn != column || !binaryCollation(info, i)) {
+                    continue;
+                }
+                
+                switch (constraint.op) {
+                    case SQLITE_INDEX_CONSTRAINT_EQ:
+                        equal = i;
+                        break;
+                    case SQLITE_INDEX_CONSTRAINT_GT:
+                    case SQLITE_INDEX_CONSTRAINT_GE:
+                        lower = i;
+                        break;
+                    case SQLITE_INDEX_CONSTRAINT_LT:
+                    case SQLITE_INDEX_CONSTRAINT_LE:
+                        upper = i;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            
+            double estimate = rows;
+            if (equal >= 0) {
+                estimate = 1;
+            }
+            else if (lower >= 0 && upper >= 0) {
+                estimate = rows / 16;
+            }
+            else if (lower >= 0 || upper >= 0) {
+                estimate = rows / 4;
+            }
+            
+            if (estimate < bestRows) {
+                bestColumn = column;
+                bestEqual = equal;
+                bestLower = lower;
+                bestUpper = upper;
+                bestRows = estimate;
+            }
+        }
+        
+        //a scan in index order saves sqlite the sort
+        if (info->nOrderBy == 1 && !info->aOrderBy[0].desc) {
+            int column = info->aOrderBy[0].iColumn;
+            if (column >= 0 && column < static_cast<int>(_columns.size())
+                && _columns[column].index != _USQL_ENUM_VALUE(TableIndex, NotIndexed)
+                && (bestColumn < 0 || bestColumn == column)) {
+                bestColumn = column;
+                info->orderByConsumed = 1;
+            }
+        }
+        
+        int flags = 0;
+        int argc = 0;
+        if (bestEqual >= 0) {
+            info->aConstraintUsage[bestEqual].argvIndex = ++argc;
+            flags |= EqualArgument;
+        }
+        else {
+            if (bestLower >= 0) {
+                info->aConstraintUsage[bestLower].argvIndex = ++argc;
+                flags |= LowerArgument | (info->aConstraint[bestLower].op == SQLITE_INDEX_CONSTRAINT_GT ? LowerStrict : 0);
+            }
+            
+            if (bestUpper >= 0) {
+                info->aConstraintUsage[bestUpper].argvIndex = ++argc;
+                flags |= UpperArgument | (info->aConstraint[bestUpper].op == SQLITE_INDEX_CONSTRAINT_LT ? UpperStrict : 0);
+            }
+        }
+        
+        info->idxNum = (bestColumn + 1) | flags;
+        info->estimatedCost = argc > 0 ? std::log(rows + 1) / std::log(2.0) + bestRows : rows;
+#if SQLITE_VERSION_NUMBER >= 3008002
+        info->estimatedRows = static_cast<sqlite3_int64>(bestRows);
+#endif
+        return SQLITE_OK;
+    }
+    
+    VirtualTableCursor *IndexedTable::openCursor() {
+        return new Cursor(this);
+    }
+    
+    void IndexedTable::invalidate() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto iter = _columns.begin(); iter != _columns.end(); ++iter) {
+            iter->order.reset();
+        }
+    }
+    
+    int IndexedTable::compareBytes(const void *a, size_t an, const void *b, size_t bn) {
+        size_t n = std::min(an, bn);
+        int order = n > 0 ? memcmp(a, b, n) : 0;
+        if (order != 0) {
+            return order;
+        }
+        
+        return an < bn ? -1 : (bn < an ? 1 : 0);
+    }
+    
+    void IndexedTable::addColumnInfo(const std::string &name, const char *type, TableIndex index) {
+        _columns.push_back(ColumnInfo(name, type, index));
+    }
+    
+    IndexedTable::_RowOrder IndexedTable::order(int column) {
+        if (_columns[column].index != _USQL_ENUM_VALUE(TableIndex, Indexed)) {
+            return _RowOrder();
+        }
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        _RowOrder &order = _columns[column].order;
+        size_t rows = rowCount();
+        if (!order || order->size() != rows) {
+            tr1::shared_ptr<RowOrder> built(new RowOrder(rows));
+            for (size_t i = 0; i < rows; ++i) {
+                (*built)[i] = i;
+            }
+            
+            std::stable_sort(built->begin(), built->end(), [this, column](size_t a, size_t b) {
+                return less(column, a, b);
+            });
+            order = built;
+        }
+        
+        return order;
+    }
+}
@@ -0,0 +1,356 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef ContainerTable_hpp
+#define ContainerTable_hpp
+
+#include "StdCpp.hpp"
+#include "VirtualTable.hpp"
+#include "DataView.hpp"
+#include <mutex>
+
+namespace usql {
+    _USQL_ENUM_CLASS_DEF(TableIndex) {
+        NotIndexed,
+        //an order of row positions, built on the first lookup and again after invalidate()
+        Indexed,
+        //the container is already sorted by the column, nothing is built
+        Presorted
+    };
+    
+    //rows of an in-memory container addressed by their position, which is also the rowid.
+    //equality and range constraints on an indexed column are answered by binary search,
+    //ORDER BY an indexed column is served in index order; sqlite checks every constraint again
+    class IndexedTable : public VirtualTable
+    {
+    public:
+        virtual std::string declaration() const;
+        virtual int bestIndex(sqlite3_index_info *info);
+        virtual VirtualTableCursor *openCursor();
+        
+        //drops the built indexes, call it after the container changed; running scans keep their order
+        void invalidate();
+        
+        size_t columnCount() const {
+            return _columns.size();
+        }
+        
+        virtual size_t rowCount() const = 0;
+        
+        //memcmp then length, the order of sqlite's BINARY collation
+        static int compareBytes(const void *a, size_t an, const void *b, size_t bn);
+        
+    protected:
+        IndexedTable() {}
+        
+        void addColumnInfo(const std::string &name, const char *type, TableIndex index);
+        
+        virtual void result(sqlite3_context *context, size_t row, int column) const = 0;
+        //false when value can not be ordered against the column, e.g. text against a number
+        virtual bool compare(size_t row, int column, sqlite3_value *value, int &order) const = 0;
+        virtual bool less(int column, size_t a, size_t b) const = 0;
+        
+    private:
+        typedef std::vector<size_t> RowOrder;
+        typedef tr1::shared_ptr<const RowOrder> _RowOrder;
+        
+        //null for a presorted column, whose positions are already the order
+        _RowOrder order(int column);
+        
+        struct ColumnInfo
+        {
+            std::string name;
+            std::string type;
+            TableIndex index;
+            _RowOrder order;
+            
+            ColumnInfo(const std::string &n, const char *t, TableIndex i) : name(n), type(t), index(i) {}
+        };
+        std::vector<ColumnInfo> _columns;
+        std::mutex _mutex;
+        
+        class Cursor;
+    };
+    
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+    //declared type, result and order of a column value; a static result points into the
+    //container instead of being copied by sqlite
+    template<class T, class Enable = void>
+    struct TableValue;
+    
+    template<class T>
+    struct TableValue<T, typename tr1::enable_if<tr1::is_arithmetic<T>::value>::type> {
+        static const char *type() {
+            return tr1::is_integral<T>::value ? "integer" : "real";
+        }
+        
+        static void result(sqlite3_context *context, T value, bool) {
+            if (tr1::is_integral<T>::value) {
+                sqlite3_result_int64(context, static_cast<sqlite3_int64>(value));
+            }
+            else {
+                sqlite3_result_double(context, static_cast<double>(value));
+            }
+        }
+        
+        static bool compare(T a, sqlite3_value *value, int &order) {
+            int type = sqlite3_value_type(value);
+            if (type == SQLITE_INTEGER && tr1::is_integral<T>::value) {
+                sqlite3_int64 x = static_cast<sqlite3_int64>(a);
+                sqlite3_int64 y = sqlite3_value_int64(value);
+                order = x < y ? -1 : (y < x ? 1 : 0);
+                return true;
+            }
+            
+            if (type == SQLITE_INTEGER || type == SQLITE_FLOAT) {
+                double x = static_cast<double>(a);
+                double y = sqlite3_value_double(value);
+                order = x < y ? -1 : (y < x ? 1 : 0);
+                return true;
+            }
+            
+            return false;
+        }
+        
+        static bool less(T a, T b) {
+            return a < b;
+        }
+    };
+    
+    //text and blobs in their sqlite storage class, compared as bytes
+    template<int SqliteType>
+    struct TableBytes {
+        static bool compare(const void *data, size_t size, sqlite3_value *value, int &order) {
+            if (sqlite3_value_type(value) != SqliteType) {
+                return false;
+            }
+            
+            //a null row sorts below every bound, as in sqlite
+            if (!data) {
+                order = -1;
+                return true;
+            }
+            
+            const void *bytes = SqliteType == SQLITE_TEXT ? static_cast<const void *>(sqlite3_value_text(value)) : sqlite3_value_blob(value);
+            order = IndexedTable::compareBytes(data, size, bytes, static_cast<size_t>(sqlite3_value_bytes(value)));
+            return true;
+        }
+        
+        //null before every value, so a consumed ORDER BY matches sqlite
+        static bool less(const void *a, size_t an, const void *b, size_t bn) {
+            if (!a || !b) {
+                return !a && b;
+            }
+            
+            return IndexedTable::compareBytes(a, an, b, bn) < 0;
+        }
+        
+        static void result(sqlite3_context *context, const void *data, size_t size, bool isStatic) {
+            if (!data) {
+                sqlite3_result_null(context);
+            }
+            else if (SqliteType == SQLITE_TEXT) {
+                sqlite3_result_text(context, static_cast<const char *>(data), static_cast<int>(size), isStatic ? SQLITE_STATIC : SQLITE_TRANSIENT);
+            }
+            else {
+                sqlite3_result_blob(context, data, static_cast<int>(size), isStatic ? SQLITE_STATIC : SQLITE_TRANSIENT);
+            }
+        }
+    };
+    
+    template<>
+    struct TableValue<std::string> {
+        static const char *type() {
+            return "text";
+        }
+        
+        static void result(sqlite3_context *context, const std::string &value, bool isStatic) {
+            TableBytes<SQLITE_TEXT>::result(context, value.data(), value.size(), isStatic);
+        }
+        
+        static bool compare(const std::string &a, sqlite3_value *value, int &order) {
+            return TableBytes<SQLITE_TEXT>::compare(a.data(), a.size(), value, order);
+        }
+        
+        static bool less(const std::string &a, const std::string &b) {
+            return IndexedTable::compareBytes(a.data(), a.size(), b.data(), b.size()) < 0;
+        }
+    };
+    
+    template<>
+    struct TableValue<const char *> {
+        static const char *type() {
+            return "text";
+        }
+        
+        static void result(sqlite3_context *context, const char *value, bool) {
+            TableBytes<SQLITE_TEXT>::result(context, value, value ? strlen(value) : 0, true);
+        }
+        
+        static bool compare(const char *a, sqlite3_value *value, int &order) {
+            return TableBytes<SQLITE_TEXT>::compare(a, a ? strlen(a) : 0, value, order);
+        }
+        
+        static bool less(const char *a, const char *b) {
+            return TableBytes<SQLITE_TEXT>::less(a, a ? strlen(a) : 0, b, b ? strlen(b) : 0);
+        }
+    };
+    
+    template<class T, int SqliteType>
+    struct TableViewValue {
+        static const char *type() {
+            return SqliteType == SQLITE_TEXT ? "text" : "blob";
+        }
+        
+        //a view is expected to point into the container
+        static void result(sqlite3_context *context, const DataView<T> &value, bool) {
+            TableBytes<SqliteType>::result(context, value.isNull() ? nullptr : value.data(), value.size(), true);
+        }
+        
+        static bool compare(const DataView<T> &a, sqlite3_value *value, int &order) {
+            return TableBytes<SqliteType>::compare(a.isNull() ? nullptr : a.data(), a.size(), value, order);
+        }
+        
+        static bool less(const DataView<T> &a, const DataView<T> &b) {
+            return TableBytes<SqliteType>::less(a.isNull() ? nullptr : a.data(), a.size(), b.isNull() ? nullptr : b.data(), b.size());
+        }
+    };
+    
+    template<>
+    struct TableValue<TextView> : public TableViewValue<char, SQLITE_TEXT> {};
+    
+    template<>
+    struct TableValue<BlobView> : public TableViewValue<unsigned char, SQLITE_BLOB> {};
+    
+    //a read-only table over a random access container such as std::vector<Row>, read in place:
+    //    auto table = ContainerTable<std::vector<Person> >::create(people);
+    //    table->addColumn("id", &Person::id, Presorted).addColumn("name", &Person::name, Indexed);
+    //    con.registerTable("people", table);
+    //columns are data members or callables taking a const Row &
+    template<class Container>
+    class ContainerTable : public IndexedTable
+    {
+    public:
+        typedef typename Container::value_type Row;
+        
+        //rows must outlive every statement reading the table and must not change during one
+        static tr1::shared_ptr<ContainerTable> create(const Container &rows) {
+            return tr1::shared_ptr<ContainerTable>(new ContainerTable(&rows, tr1::shared_ptr<const Container>()));
+        }
+        
+        //keeps rows alive as long as the table
+        static tr1::shared_ptr<ContainerTable> create(const tr1::shared_ptr<const Container> &rows) {
+            return tr1::shared_ptr<ContainerTable>(new ContainerTable(rows.get(), rows));
+        }
+        
+        //columns are declared when the table is first used, add them all before that
+        template<class T>
+        ContainerTable &addColumn(const std::string &name, T Row::*member, TableIndex index = _USQL_ENUM_VALUE(TableIndex, NotIndexed)) {
+            return addColumn(name, MemberAccessor<T>(member), index);
+        }
+        
+        template<class F>
+        ContainerTable &addColumn(const std::string &name, F accessor, TableIndex index = _USQL_ENUM_VALUE(TableIndex, NotIndexed)) {
+            typedef decltype(tr1::declval<const F &>()(tr1::declval<const Row &>())) R;
+            typedef typename tr1::decay<R>::type T;
+            //a string returned by value is a temporary, sqlite has to copy it
+            bool isStatic = tr1::is_reference<R>::value || !tr1::is_same<T, std::string>::value;
+            addColumnInfo(name, TableValue<T>::type(), index);
+            _accessors.push_back(tr1::shared_ptr<Accessor>(new TypedAccessor<T, F>(accessor, isStatic)));
+            return *this;
+        }
+        
+        virtual size_t rowCount() const {
+            return _rows->size();
+        }
+        
+    protected:
+        virtual void result(sqlite3_context *context, size_t row, int column) const {
+            _accessors[column]->result(context, at(row));
+        }
+        
+        virtual bool compare(size_t row, int column, sqlite3_value *value, int &order) const {
+            return _accessors[column]->compare(at(row), value, order);
+        }
+        
+        virtual bool less(int column, size_t a, size_t b) const {
+            return _accessors[column]->less(at(a), at(b));
+        }
+        
+    private:
+        ContainerTable(const Container *rows, const tr1::shared_ptr<const Container> &owner) : _rows(rows), _owner(owner) {}
+        
+        const Row &at(size_t i) const {
+            return _rows->begin()[i];
+        }
+        
+        template<class T>
+        struct MemberAccessor {
+            T Row::*member;
+            
+            MemberAccessor(T Row::*m) : member(m) {}
+            
+            const T &operator()(const Row &row) const {
+                return row.*member;
+            }
+        };
+        
+        struct Accessor {
+            virtual ~Accessor() {}
+            virtual void result(sqlite3_context *context, const Row &row) const = 0;
+            virtual bool compare(const Row &row, sqlite3_value *value, int &order) const = 0;
+            virtual bool less(const Row &a, const Row &b) const = 0;
+        };
+        
+        template<class T, class F>
+        struct TypedAccessor : public Accessor {
+            F func;
+            bool isStatic;
+            
+            TypedAccessor(const F &f, bool s) : func(f), isStatic(s) {}
+            
+            virtual void result(sqlite3_context *context, const Row &row) const {
+                TableValue<T>::result(context, func(row), isStatic);
+            }
+            
+            virtual bool compare(const Row &row, sqlite3_value *value, int &order) const {
+                return TableValue<T>::compare(func(row), value, order);
+            }
+            
+            virtual bool less(const Row &a, const Row &b) const {
+                return TableValue<T>::less(func(a), func(b));
+            }
+        };
+        
+        const Container *_rows;
+        tr1::shared_ptr<const Container> _owner;
+        std::vector<tr1::shared_ptr<Accessor> > _accessors;
+    };
+#endif
+}
+
+#endif /* ContainerTable_hpp */
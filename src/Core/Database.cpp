@@ -27,6 +27,11 @@
 #include "Database.hpp"
 #include "Utils.hpp"
 #include "Statement.hpp"
+#include <thread>
+#if _USQL_SQLITE_UNLOCK_NOTIFY_ENABLE
+#include <mutex>
+#include <condition_variable>
+#endif
 
 namespace usql {
     Database::~Database() {
@@ -42,7 +47,15 @@ namespace usql {
             return SQLITE_OK;
         }
         
-        return sqlite3_open_v2(filepath.c_str(), &_db, flags, nullptr);
+        int code = sqlite3_open_v2(filepath.c_str(), &_db, flags, nullptr);
+        if (_USQL_OK(code)) {
+            applyBusyPolicy();
+            if (_profiler) {
+                _profiler->attach(_db);
+            }
+        }
+        
+        return code;
     }
     
     int Database::close() {
@@ -71,43 +84,183 @@ namespace usql {
         return sqlite3_errmsg(_db);
     }
     
-    void Database::registerStatement(Statement *stmt) {
-        if (!stmt) {
-            return;
+    void Database::setBusyPolicy(const BusyPolicy &policy) {
+        _busyPolicy = policy;
+        _busyPolicy.timeout = std::max(0, _busyPolicy.timeout);
+        _busyPolicy.initialDelay = std::max(1, _busyPolicy.initialDelay);
+        _busyPolicy.maxDelay = std::max(_busyPolicy.initialDelay, _busyPolicy.maxDelay);
+        _busyPolicy.multiplier = std::max(1.0, _busyPolicy.multiplier);
+        _busyPolicy.jitter = std::max(0.0, std::min(1.0, _busyPolicy.jitter));
+        applyBusyPolicy();
+    }
+    
+    void Database::setProfiler(_Profiler profiler) {
+        if (isOpening()) {
+            if (_profiler) {
+                _profiler->detach(_db);
+            }
+            
+            if (profiler) {
+                profiler->attach(_db);
+            }
         }
         
-        auto ret = std::find(_statements.begin(), _statements.end(), stmt);
-        if (ret != _statements.end()) {
+        _profiler = profiler;
+    }
+    
+    void Database::applyBusyPolicy() {
+        if (!isOpening()) {
             return;
         }
         
-        _statements.push_back(stmt);
+        sqlite3_busy_handler(_db, _busyPolicy.timeout > 0 ? &Database::busyHandler : nullptr, this);
     }
     
-    void Database::unregisterStatement(Statement *stmt) {
-        if (!stmt) {
+    int Database::busyHandler(void *arg, int count) {
+        return static_cast<Database *>(arg)->busy(count);
+    }
+    
+    int Database::busy(int count) {
+        Clock::time_point now = Clock::now();
+        if (count == 0 || !_busyWaiting) {
+            _busyWaiting = true;
+            _busyBegin = now;
+        }
+        
+        double remaining = _busyPolicy.timeout * 1000.0 - std::chrono::duration<double, std::micro>(now - _busyBegin).count();
+        if (remaining <= 0) {
+            ++_busyStats.timeouts;
+            finishBusyWait();
+            return 0;
+        }
+        
+        double delay = _busyPolicy.initialDelay;
+        for (int i = 0; i < count && delay < _busyPolicy.maxDelay; ++i) {
+            delay *= _busyPolicy.multiplier;
+        }
+        delay = std::min<double>(delay, _busyPolicy.maxDelay);
+        
+        //xorshift, spreads out waiters that hit the lock at the same time
+        _random ^= _random << 13;
+        _random ^= _random >> 17;
+        _random ^= _random << 5;
+        delay *= 1.0 - _busyPolicy.jitter * (_random / 4294967296.0);
+        
+        ++_busyStats.retries;
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(std::max(1.0, std::min(delay, remaining)))));
+        return 1;
+    }
+    
+    void Database::finishBusyWait() {
+        _busyWaiting = false;
+        _busyStats.waits.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _busyBegin).count()));
+    }
+    
+#if _USQL_SQLITE_UNLOCK_NOTIFY_ENABLE
+    namespace {
+        struct UnlockNotification
+        {
+            std::mutex mutex;
+            std::condition_variable fired;
+            bool unlocked;
+            
+            UnlockNotification() : unlocked(false) {}
+        };
+        
+        void unlockNotify(void **args, int count) {
+            for (int i = 0; i < count; ++i) {
+                UnlockNotification *notification = static_cast<UnlockNotification *>(args[i]);
+                std::lock_guard<std::mutex> lock(notification->mutex);
+                notification->unlocked = true;
+                notification->fired.notify_one();
+            }
+        }
+    }
+    
+    bool Database::waitForUnlock() {
+        if (!isOpening() || !_busyPolicy.unlockNotify || _busyPolicy.timeout <= 0) {
+            return false;
+        }
+        
+        UnlockNotification notification;
+        //SQLITE_LOCKED here means waiting would deadlock
+        if (sqlite3_unlock_notify(_db, &unlockNotify, &notification) != SQLITE_OK) {
+            return false;
+        }
+        
+        ++_busyStats.unlockNotifications;
+        Clock::time_point begin = Clock::now();
+        bool unlocked = false;
+        {
+            std::unique_lock<std::mutex> lock(notification.mutex);
+            unlocked = notification.fired.wait_for(lock, std::chrono::milliseconds(_busyPolicy.timeout), [&notification]() {
+                return notification.unlocked;
+            });
+        }
+        
+        if (!unlocked) {
+            //cancel, the callback must not fire once the notification is gone
+            sqlite3_unlock_notify(_db, nullptr, nullptr);
+            ++_busyStats.timeouts;
+        }
+        
+        _busyStats.waits.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count()));
+        return unlocked;
+    }
+#endif
+    
+    void Database::registerStatement(Statement *stmt) {
+        if (!stmt || stmt->_registry) {
             return;
         }
         
-        auto ret = std::find(_statements.begin(), _statements.end(), stmt);
-        if (ret != _statements.end()) {
-            _statements.remove(stmt);
+        stmt->_registry = this;
+        stmt->_registryPrev = nullptr;
+        stmt->_registryNext = _statements;
+        if (_statements) {
+            _statements->_registryPrev = stmt;
         }
+        _statements = stmt;
+        ++_statementCount;
     }
     
-    void Database::finilizeAllStatements(bool finilized) {
-        if (_statements.size() == 0) {
+    void Database::unregisterStatement(Statement *stmt) {
+        if (!stmt || stmt->_registry != this) {
             return;
         }
         
-        auto list = _statements;
-        _statements.clear();
+        if (stmt->_registryPrev) {
+            stmt->_registryPrev->_registryNext = stmt->_registryNext;
+        }
+        else {
+            _statements = stmt->_registryNext;
+        }
+        
+        if (stmt->_registryNext) {
+            stmt->_registryNext->_registryPrev = stmt->_registryPrev;
+        }
+        
+        stmt->_registry = nullptr;
+        stmt->_registryPrev = nullptr;
+        stmt->_registryNext = nullptr;
+        --_statementCount;
+    }
+    
+    void Database::finilizeAllStatements(bool finilized) {
+        Statement *stmt = _statements;
+        _statements = nullptr;
+        _statementCount = 0;
         
-        for (auto iter = list.begin(); iter != list.end(); ++iter) {
-            Statement *stmt = *iter;
+        while (stmt) {
+            Statement *next = stmt->_registryNext;
+            stmt->_registry = nullptr;
+            stmt->_registryPrev = nullptr;
+            stmt->_registryNext = nullptr;
             if (finilized) {
                 stmt->finilize();
             }
+            
+            stmt = next;
         }
     }
 }
\ No newline at end of file
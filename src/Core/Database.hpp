@@ -28,9 +28,54 @@
 #define Database_hpp
 
 #include "StdCpp.hpp"
+#include "USQLDefs.hpp"
 #include "Object.hpp"
+#include "Histogram.hpp"
+#include "Profiler.hpp"
+#include <chrono>
 
 namespace usql {
+    //retries of a locked database, delays grow by multiplier from initialDelay up to maxDelay,
+    //each shortened by a random share of up to jitter
+    struct BusyPolicy
+    {
+        //milliseconds to keep retrying, 0 returns SQLITE_BUSY at once
+        int timeout;
+        //microseconds
+        int initialDelay;
+        int maxDelay;
+        double multiplier;
+        //0.0 ~ 1.0
+        double jitter;
+        //waits for shared cache table locks through sqlite3_unlock_notify instead of returning SQLITE_LOCKED
+        bool unlockNotify;
+        
+        BusyPolicy()
+        : timeout(0)
+        , initialDelay(USQL_DEFAULT_BUSY_INITIAL_DELAY)
+        , maxDelay(USQL_DEFAULT_BUSY_MAX_DELAY)
+        , multiplier(2.0)
+        , jitter(0.5)
+        , unlockNotify(false) {}
+        
+        static BusyPolicy backoff(int timeout) {
+            BusyPolicy policy;
+            policy.timeout = timeout;
+            return policy;
+        }
+    };
+    
+    struct BusyStats
+    {
+        //time a step spent blocked, one sample per step that hit a lock
+        Histogram waits;
+        uint64_t retries;
+        uint64_t timeouts;
+        uint64_t unlockNotifications;
+        
+        BusyStats() : retries(0), timeouts(0), unlockNotifications(0) {}
+    };
+    
     class Database;
     typedef tr1::shared_ptr<Database> _Database;
     typedef tr1::weak_ptr<Database> _WeakDatabase;
@@ -59,18 +104,71 @@ namespace usql {
         
         std::string errorDescription(int code) const;
         
+        //kept across close and open
+        void setBusyPolicy(const BusyPolicy &policy);
+        const BusyPolicy &busyPolicy() const {
+            return _busyPolicy;
+        }
+        
+        const BusyStats &busyStats() const {
+            return _busyStats;
+        }
+        
+        void resetBusyStats() {
+            _busyStats = BusyStats();
+        }
+        
+        //closes the current busy wait once the blocked call returned
+        void endBusyWait() {
+            if (_busyWaiting) {
+                finishBusyWait();
+            }
+        }
+        
+        //kept across close and open, null stops profiling
+        void setProfiler(_Profiler profiler);
+        _Profiler profiler() const {
+            return _profiler;
+        }
+        
+#if _USQL_SQLITE_UNLOCK_NOTIFY_ENABLE
+        //blocks until the shared cache lock holder finishes, false on deadlock, timeout or if disabled
+        bool waitForUnlock();
+#endif
+        
     public:
+        //prepared statements are linked into an intrusive list, register and unregister are O(1)
         void registerStatement(Statement *stmt);
         void unregisterStatement(Statement *stmt);
         void finilizeAllStatements(bool finilized);
+        
+        size_t statementCount() const {
+            return _statementCount;
+        }
 
 	private:
-		Database(): _db(nullptr) {}
+		Database(): _db(nullptr), _busyWaiting(false), _random(0x9e3779b9u), _statements(nullptr), _statementCount(0) {}
+        
+        static int busyHandler(void *arg, int count);
+        int busy(int count);
+        void applyBusyPolicy();
+        void finishBusyWait();
         
     private:
+        typedef std::chrono::steady_clock Clock;
+        
         sqlite3 *_db;
         
-        std::list<Statement *> _statements;
+        BusyPolicy _busyPolicy;
+        BusyStats _busyStats;
+        bool _busyWaiting;
+        Clock::time_point _busyBegin;
+        uint32_t _random;
+        
+        Statement *_statements;
+        size_t _statementCount;
+        
+        _Profiler _profiler;
     };
 }
 
@@ -0,0 +1,77 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "Histogram.hpp"
+
+namespace usql {
+    void Histogram::record(uint64_t microseconds) {
+        size_t i = 0;
+        while (i + 1 < BucketCount && bucketUpperBound(i) < microseconds) {
+            ++i;
+        }
+        
+        ++_buckets[i];
+        ++_count;
+        _total += microseconds;
+        _max = std::max(_max, microseconds);
+    }
+    
+    void Histogram::clear() {
+        std::fill(_buckets, _buckets + BucketCount, 0);
+        _count = 0;
+        _total = 0;
+        _max = 0;
+    }
+    
+    void Histogram::merge(const Histogram &other) {
+        for (size_t i = 0; i < BucketCount; ++i) {
+            _buckets[i] += other._buckets[i];
+        }
+        
+        _count += other._count;
+        _total += other._total;
+        _max = std::max(_max, other._max);
+    }
+    
+    uint64_t Histogram::percentile(double p) const {
+        if (_count == 0) {
+            return 0;
+        }
+        
+        uint64_t rank = static_cast<uint64_t>(std::max(0.0, std::min(1.0, p)) * _count);
+        rank = std::max<uint64_t>(1, rank);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BucketCount; ++i) {
+            seen += _buckets[i];
+            if (seen >= rank) {
+                return std::min(bucketUpperBound(i), _max);
+            }
+        }
+        
+        return _max;
+    }
+}
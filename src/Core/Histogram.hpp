@@ -0,0 +1,87 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef Histogram_hpp
+#define Histogram_hpp
+
+#include "StdCpp.hpp"
+#include "Object.hpp"
+
+namespace usql {
+    //latency histogram in microseconds with power of two buckets:
+    //bucket 0 holds [0, 1], bucket i holds (2^(i-1), 2^i], the last one everything above
+    class Histogram : public Object
+    {
+    public:
+        enum {
+            BucketCount = 40
+        };
+        
+        Histogram() {
+            clear();
+        }
+        
+        void record(uint64_t microseconds);
+        void clear();
+        void merge(const Histogram &other);
+        
+        uint64_t count() const {
+            return _count;
+        }
+        
+        uint64_t totalMicroseconds() const {
+            return _total;
+        }
+        
+        uint64_t maxMicroseconds() const {
+            return _max;
+        }
+        
+        double averageMicroseconds() const {
+            return _count ? static_cast<double>(_total) / _count : 0;
+        }
+        
+        //upper bound of the bucket holding the percentile, 0.0 ~ 1.0
+        uint64_t percentile(double p) const;
+        
+        uint64_t bucket(size_t i) const {
+            return i < BucketCount ? _buckets[i] : 0;
+        }
+        
+        static uint64_t bucketUpperBound(size_t i) {
+            return i == 0 ? 1 : (static_cast<uint64_t>(1) << std::min<size_t>(i, 63));
+        }
+        
+    private:
+        uint64_t _buckets[BucketCount];
+        uint64_t _count;
+        uint64_t _total;
+        uint64_t _max;
+    };
+}
+
+#endif /* Histogram_hpp */
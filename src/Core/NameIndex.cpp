@@ -0,0 +1,97 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "NameIndex.hpp"
+#include "Utils.hpp"
+
+namespace usql {
+    void NameIndex::reset(size_t count) {
+        clear();
+        
+        size_t slots = 4;
+        while (slots < count * 2) {
+            slots <<= 1;
+        }
+        
+        _names.reserve(count);
+        _values.reserve(count);
+        _slots.assign(slots, -1);
+    }
+    
+    void NameIndex::clear() {
+        _names.clear();
+        _values.clear();
+        _slots.clear();
+    }
+    
+    void NameIndex::insert(const std::string &name, int value) {
+        if (name.empty()) {
+            return;
+        }
+        
+        if (_slots.empty() || (_names.size() + 1) * 2 > _slots.size()) {
+            std::vector<std::string> names;
+            std::vector<int> values;
+            names.swap(_names);
+            values.swap(_values);
+            
+            reset((names.size() + 1) * 2);
+            for (size_t i = 0; i < names.size(); ++i) {
+                insert(names[i], values[i]);
+            }
+        }
+        
+        size_t slot = slotForName(name);
+        if (_slots[slot] >= 0) {
+            _values[_slots[slot]] = value;
+            return;
+        }
+        
+        _slots[slot] = static_cast<int>(_names.size());
+        _names.push_back(name);
+        _values.push_back(value);
+    }
+    
+    int NameIndex::find(const std::string &name, int invalid) const {
+        if (name.empty() || _slots.empty()) {
+            return invalid;
+        }
+        
+        int pos = _slots[slotForName(name)];
+        return pos < 0 ? invalid : _values[pos];
+    }
+    
+    size_t NameIndex::slotForName(const std::string &name) const {
+        size_t mask = _slots.size() - 1;
+        size_t slot = Utils::hash(name.data(), name.size()) & mask;
+        while (_slots[slot] >= 0 && _names[_slots[slot]] != name) {
+            slot = (slot + 1) & mask;
+        }
+        
+        return slot;
+    }
+}
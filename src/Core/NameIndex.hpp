@@ -0,0 +1,71 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef NameIndex_hpp
+#define NameIndex_hpp
+
+#include "StdCpp.hpp"
+#include "Object.hpp"
+
+namespace usql {
+    //maps names to integer values through an open addressing table,
+    //built once per prepare for column and parameter lookups
+    class NameIndex : public Object
+    {
+    public:
+        NameIndex() {}
+        
+        //drops all names and makes room for count names
+        void reset(size_t count);
+        void clear();
+        
+        //the last value wins when a name is inserted twice, empty names are ignored
+        void insert(const std::string &name, int value);
+        
+        //returns invalid if the name is unknown
+        int find(const std::string &name, int invalid) const;
+        
+        size_t size() const {
+            return _names.size();
+        }
+        
+        bool empty() const {
+            return _names.empty();
+        }
+        
+    private:
+        size_t slotForName(const std::string &name) const;
+        
+    private:
+        std::vector<std::string> _names;
+        std::vector<int> _values;
+        //positions in _names, -1 for empty slots
+        std::vector<int> _slots;
+    };
+}
+
+#endif /* NameIndex_hpp */
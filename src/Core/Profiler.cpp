@@ -0,0 +1,199 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "Profiler.hpp"
+
+#define USQL_PROFILER_OTHER_SQL "(other)"
+
+namespace usql {
+    void Profiler::attach(sqlite3 *db) {
+        unsigned mask = SQLITE_TRACE_PROFILE;
+        if (_options.countRows) {
+            mask |= SQLITE_TRACE_STMT | SQLITE_TRACE_ROW;
+        }
+        
+        sqlite3_trace_v2(db, mask, &Profiler::trace, this);
+    }
+    
+    void Profiler::detach(sqlite3 *db) {
+        sqlite3_trace_v2(db, 0, nullptr, nullptr);
+        _rows.clear();
+    }
+    
+    int Profiler::trace(unsigned type, void *context, void *p, void *x) {
+        Profiler *profiler = static_cast<Profiler *>(context);
+        sqlite3_stmt *stmt = static_cast<sqlite3_stmt *>(p);
+        if (type == SQLITE_TRACE_ROW) {
+            ++profiler->_rows[stmt];
+        }
+        else if (type == SQLITE_TRACE_STMT) {
+            //a trigger program starts with "--", its rows belong to the outer statement
+            const char *sql = static_cast<const char *>(x);
+            if (!sql || sql[0] != '-' || sql[1] != '-') {
+                profiler->_rows[stmt] = 0;
+            }
+        }
+        else if (type == SQLITE_TRACE_PROFILE) {
+            profiler->profile(stmt, *static_cast<sqlite3_int64 *>(x));
+        }
+        
+        return 0;
+    }
+    
+    void Profiler::profile(sqlite3_stmt *stmt, sqlite3_int64 nanoseconds) {
+        StatementCounters counters;
+        counters.fullscanSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+        counters.sorts = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+        counters.autoindexes = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+        counters.vmSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+        uint64_t memory = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_MEMUSED, 0);
+        
+        uint64_t rows = 0;
+        if (_options.countRows) {
+            auto iter = _rows.find(stmt);
+            if (iter != _rows.end()) {
+                rows = iter->second;
+                _rows.erase(iter);
+            }
+        }
+        
+        double milliseconds = nanoseconds / 1000000.0;
+        bool slow = _options.slowQueryThreshold >= 0 && milliseconds >= _options.slowQueryThreshold;
+        
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            StatementProfile &profile = profileForStatement(stmt);
+            ++profile.executions;
+            profile.rows += rows;
+            profile.latency.record(static_cast<uint64_t>(nanoseconds / 1000));
+            profile.counters.fullscanSteps += counters.fullscanSteps;
+            profile.counters.sorts += counters.sorts;
+            profile.counters.autoindexes += counters.autoindexes;
+            profile.counters.vmSteps += counters.vmSteps;
+            profile.maxMemory = std::max(profile.maxMemory, memory);
+            if (slow) {
+                ++profile.slowExecutions;
+            }
+        }
+        
+        if (!slow) {
+            return;
+        }
+        
+        SlowQuery query;
+        query.milliseconds = milliseconds;
+        query.rows = rows;
+        query.counters = counters;
+        
+        char *expanded = _options.expandSlowQueries ? sqlite3_expanded_sql(stmt) : nullptr;
+        if (expanded) {
+            query.sql = expanded;
+            sqlite3_free(expanded);
+        }
+        else {
+            const char *sql = sqlite3_sql(stmt);
+            query.sql = sql ? sql : "";
+        }
+        
+        if (_options.slowQueryLogSize > 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _slowQueries.push_back(query);
+            while (_slowQueries.size() > _options.slowQueryLogSize) {
+                _slowQueries.pop_front();
+            }
+        }
+        
+        if (_options.slowQueryHandler) {
+            _options.slowQueryHandler(query);
+        }
+    }
+    
+    StatementProfile &Profiler::profileForStatement(sqlite3_stmt *stmt) {
+        const char *sql = sqlite3_sql(stmt);
+        if (!sql) {
+            sql = "";
+        }
+        
+        auto cached = _statements.find(stmt);
+        if (cached != _statements.end() && _profiles[cached->second].sql == sql) {
+            return _profiles[cached->second];
+        }
+        
+        //handles of finalized statements pile up, the sql lookup refills the cache
+        if (_statements.size() > _profiles.size() * 2 + 64) {
+            _statements.clear();
+        }
+        
+        std::string text(sql);
+        auto iter = _sql.find(text);
+        if (iter == _sql.end() && _profiles.size() >= _options.maxStatements) {
+            //not cached by handle, the sql of the overflow profile never matches
+            iter = _sql.find(USQL_PROFILER_OTHER_SQL);
+            if (iter == _sql.end()) {
+                iter = _sql.insert(std::make_pair(std::string(USQL_PROFILER_OTHER_SQL), _profiles.size())).first;
+                _profiles.push_back(StatementProfile());
+                _profiles.back().sql = USQL_PROFILER_OTHER_SQL;
+            }
+            return _profiles[iter->second];
+        }
+        
+        if (iter == _sql.end()) {
+            iter = _sql.insert(std::make_pair(text, _profiles.size())).first;
+            _profiles.push_back(StatementProfile());
+            _profiles.back().sql = text;
+        }
+        
+        _statements[stmt] = iter->second;
+        return _profiles[iter->second];
+    }
+    
+    std::vector<StatementProfile> Profiler::snapshot() const {
+        std::vector<StatementProfile> profiles;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            profiles = _profiles;
+        }
+        
+        std::stable_sort(profiles.begin(), profiles.end(), [](const StatementProfile &a, const StatementProfile &b) {
+            return a.latency.totalMicroseconds() > b.latency.totalMicroseconds();
+        });
+        return profiles;
+    }
+    
+    std::vector<SlowQuery> Profiler::slowQueries() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return std::vector<SlowQuery>(_slowQueries.begin(), _slowQueries.end());
+    }
+    
+    void Profiler::reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _profiles.clear();
+        _sql.clear();
+        _statements.clear();
+        _slowQueries.clear();
+    }
+}
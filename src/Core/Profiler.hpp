@@ -0,0 +1,146 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef Profiler_hpp
+#define Profiler_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Histogram.hpp"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace usql {
+    //sqlite3_stmt_status counters of one execution, or their sums
+    struct StatementCounters
+    {
+        uint64_t fullscanSteps;
+        uint64_t sorts;
+        uint64_t autoindexes;
+        uint64_t vmSteps;
+        
+        StatementCounters() : fullscanSteps(0), sorts(0), autoindexes(0), vmSteps(0) {}
+    };
+    
+    //everything recorded for one sql text
+    struct StatementProfile
+    {
+        std::string sql;
+        uint64_t executions;
+        uint64_t slowExecutions;
+        uint64_t rows;
+        //microseconds per execution
+        Histogram latency;
+        StatementCounters counters;
+        //largest memory a prepared statement of this text held, in bytes
+        uint64_t maxMemory;
+        
+        StatementProfile() : executions(0), slowExecutions(0), rows(0), maxMemory(0) {}
+    };
+    
+    struct SlowQuery
+    {
+        //with its bound values when ProfilerOptions::expandSlowQueries is set
+        std::string sql;
+        double milliseconds;
+        uint64_t rows;
+        StatementCounters counters;
+        
+        SlowQuery() : milliseconds(0), rows(0) {}
+    };
+    
+    struct ProfilerOptions
+    {
+        //milliseconds, executions at least this slow are logged, negative disables the log
+        int slowQueryThreshold;
+        //slow queries kept for slowQueries(), the oldest are dropped
+        size_t slowQueryLogSize;
+        //called on the executing thread for every slow query
+        tr1::function<void(const SlowQuery &)> slowQueryHandler;
+        bool expandSlowQueries;
+        //one trace callback per row
+        bool countRows;
+        //distinct sql texts, the executions of any further text are summed up under "(other)"
+        size_t maxStatements;
+        
+        ProfilerOptions()
+        : slowQueryThreshold(USQL_DEFAULT_SLOW_QUERY_THRESHOLD)
+        , slowQueryLogSize(USQL_DEFAULT_SLOW_QUERY_LOG_SIZE)
+        , expandSlowQueries(false)
+        , countRows(true)
+        , maxStatements(USQL_DEFAULT_PROFILER_STATEMENTS) {}
+    };
+    
+    class Profiler;
+    typedef tr1::shared_ptr<Profiler> _Profiler;
+    
+    //per sql text statistics fed by sqlite3_trace_v2 and sqlite3_stmt_status,
+    //recorded on the connection's thread and readable from any other
+    class Profiler : public NoCopyable
+    {
+    public:
+        static _Profiler create(const ProfilerOptions &options) {
+            return _Profiler(new Profiler(options));
+        }
+        
+        void attach(sqlite3 *db);
+        void detach(sqlite3 *db);
+        
+        const ProfilerOptions &options() const {
+            return _options;
+        }
+        
+        //copies of all profiles, the slowest in total first
+        std::vector<StatementProfile> snapshot() const;
+        std::vector<SlowQuery> slowQueries() const;
+        void reset();
+        
+    private:
+        Profiler(const ProfilerOptions &options) : _options(options) {}
+        
+        static int trace(unsigned type, void *context, void *p, void *x);
+        void profile(sqlite3_stmt *stmt, sqlite3_int64 nanoseconds);
+        StatementProfile &profileForStatement(sqlite3_stmt *stmt);
+        
+    private:
+        ProfilerOptions _options;
+        
+        mutable std::mutex _mutex;
+        std::vector<StatementProfile> _profiles;
+        std::unordered_map<std::string, size_t> _sql;
+        //statements seen before, checked against the sql text since handles are reused
+        std::unordered_map<sqlite3_stmt *, size_t> _statements;
+        std::deque<SlowQuery> _slowQueries;
+        
+        //rows of the running executions, only touched by the connection's thread
+        std::unordered_map<sqlite3_stmt *, uint64_t> _rows;
+    };
+}
+
+#endif /* Profiler_hpp */
@@ -33,7 +33,17 @@ namespace usql {
     : _stmt(nullptr)
     , _command(cmd)
     , _db(db)
-    , _parametersCount(0) {
+    , _columnCount(0)
+    , _hasRow(false)
+    , _stepped(false)
+    , _prepareCount(0)
+    , _parametersCount(0)
+    , _registry(nullptr)
+    , _registryPrev(nullptr)
+    , _registryNext(nullptr) {
+#if _USQL_VIEW_GUARD_ENABLE
+        _generation = tr1::shared_ptr<uint64_t>(new uint64_t(0));
+#endif
     }
     
     Statement::~Statement() {
@@ -47,6 +57,7 @@ namespace usql {
         
         sqlite3_finalize(_stmt);
         _stmt = nullptr;
+        _stepped = false;
         if (!_db.expired()) {
             _db.lock()->unregisterStatement(this);
         }
@@ -69,16 +80,19 @@ namespace usql {
         auto ptr = _db.lock();
         sqlite3 *db = ptr->db();
         Result ret(sqlite3_prepare_v2(db, _command.c_str(), static_cast<int>(_command.size() + 1), &_stmt, nullptr), _db);
+        ptr->endBusyWait();
         if (ret) {
             ptr->registerStatement(this);
             initParameters();
+            initColumnInfo();
         }
         
         return ret;
     }
     
     Result Statement::reset() {
-        clearColumnInfo();
+        invalidateRow();
+        _stepped = false;
         if (_stmt) {
             return Result(sqlite3_reset(_stmt), _db);
         }
@@ -87,13 +101,24 @@ namespace usql {
         }
     }
     
+    Result Statement::clearBindings() {
+        if (!_stmt) {
+            return Result::error();
+        }
+        
+        return Result(sqlite3_clear_bindings(_stmt), _db);
+    }
+    
     Result Statement::step() {
-        Result ret = reset();
-        if (!ret) {
-            return ret;
+        if (_stepped || !_stmt) {
+            Result ret = reset();
+            if (!ret) {
+                return ret;
+            }
         }
         
-        return Result::step(sqlite3_step(_stmt), _db);
+        _stepped = true;
+        return Result::step(stepStatement(true), _db);
     }
     
     Result Statement::query() {
@@ -101,33 +126,52 @@ namespace usql {
             return Result::error();
         }
         
-        Result ret = Result::query(sqlite3_step(_stmt), _db);
-        if (ret) {
+        bool first = !_hasRow;
+        invalidateRow();
+        _stepped = true;
+        Result ret = Result::query(stepStatement(first), _db);
+        if (ret && first && columnInfoExpired()) {
+            //sqlite re-prepared the statement, e.g. after the schema changed
             initColumnInfo();
         }
         
+        _hasRow = ret.isSuccess();
         return ret;
     }
     
-    int Statement::columnIndexForName(const std::string &name) const {
-        if (name.empty()) {
-            return USQL_INVALID_COLUMN_INDEX;
+    int Statement::stepStatement(bool restartable) {
+        int code = sqlite3_step(_stmt);
+        if (!_registry) {
+            return code;
         }
         
-        auto iter = _columns.find(name);
-        if (iter == _columns.end()) {
-            return USQL_INVALID_COLUMN_INDEX;
+        _registry->endBusyWait();
+#if _USQL_SQLITE_UNLOCK_NOTIFY_ENABLE
+        //a shared cache table lock, the statement is restarted once the holder finishes
+        while (restartable && code == SQLITE_LOCKED
+               && sqlite3_extended_errcode(_registry->db()) == SQLITE_LOCKED_SHAREDCACHE
+               && _registry->waitForUnlock()) {
+            sqlite3_reset(_stmt);
+            code = sqlite3_step(_stmt);
+            _registry->endBusyWait();
         }
+#else
+        (void)restartable;
+#endif
         
-        return iter->second;
+        return code;
+    }
+    
+    int Statement::columnIndexForName(const std::string &name) const {
+        return _columns.find(name, USQL_INVALID_COLUMN_INDEX);
     }
     
     ColumnType Statement::typeForColumnIndex(size_t i) const {
-        if (i >= _columnTypes.size()) {
+        if (!_hasRow || i >= static_cast<size_t>(_columnCount)) {
             return _USQL_ENUM_VALUE(ColumnType, InvalidType);
         }
         
-        return _columnTypes[i];
+        return columnType(sqlite3_column_type(_stmt, static_cast<int>(i)));
     }
     
     void Statement::initColumnInfo() {
@@ -136,30 +180,36 @@ namespace usql {
             return ;
         }
         
+#ifdef SQLITE_STMTSTATUS_REPREPARE
+        _prepareCount = sqlite3_stmt_status(_stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+#endif
+        
         int count = sqlite3_column_count(_stmt);
         if (count <= 0) {
             return ;
         }
         
+        _columnCount = count;
+        _columns.reset(count);
         for (int i = 0; i < count; ++i) {
             const char *name = sqlite3_column_name(_stmt, i);
-            if (!name || name[0] == 0) {
-                return ;
+            if (name) {
+                //the last column wins when names are duplicated
+                _columns.insert(name, i);
             }
-            
-            _columns[name] = i;
-            
-            ColumnType type = typeForColumn(i);
-            if (type == _USQL_ENUM_VALUE(ColumnType, InvalidType)) {
-                return;
-            }
-            _columnTypes.push_back(type);
         }
     }
     
-    ColumnType Statement::typeForColumn(int i) {
+    bool Statement::columnInfoExpired() const {
+#ifdef SQLITE_STMTSTATUS_REPREPARE
+        return sqlite3_stmt_status(_stmt, SQLITE_STMTSTATUS_REPREPARE, 0) != _prepareCount;
+#else
+        return true;
+#endif
+    }
+    
+    ColumnType Statement::columnType(int t) {
         ColumnType type = _USQL_ENUM_VALUE(ColumnType, InvalidType);
-        int t = sqlite3_column_type(_stmt, i);
         switch (t) {
             case SQLITE_INTEGER:
                 type = _USQL_ENUM_VALUE(ColumnType, Integer);
@@ -197,20 +247,16 @@ namespace usql {
             return;
         }
         
+        _parameters.reset(_parametersCount);
         for (int i = 1; i <= _parametersCount; ++i) {
             const char *name = sqlite3_bind_parameter_name(_stmt, i);
             if (name && name[0]) {
-                _nameParameters[name] = i;
+                _parameters.insert(name, i);
             }
         }
     }
     
     int Statement::parameterIndexForName(const std::string &name) const {
-        if (name.empty()) {
-            return USQL_INVALID_PARAMETER_INDEX;
-        }
-        
-        auto iter = _nameParameters.find(name);
-        return iter == _nameParameters.end() ? USQL_INVALID_PARAMETER_INDEX : iter->second;
+        return _parameters.find(name, USQL_INVALID_PARAMETER_INDEX);
     }
 }
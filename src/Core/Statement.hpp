@@ -33,6 +33,8 @@
 #include "Object.hpp"
 #include "Result.hpp"
 #include "Database.hpp"
+#include "DataView.hpp"
+#include "NameIndex.hpp"
 
 namespace usql {
 //#if !_USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
@@ -42,7 +44,10 @@ namespace usql {
 			Int64Value,
 			DoubleValue,
 			TextValue,
-			BlobValue
+			BlobValue,
+			ZeroBlobValue,
+			PointerValue,
+			NullValue
 	};
 
 	struct BindValue{
@@ -52,10 +57,13 @@ namespace usql {
 			double d;
 			const char *str;
 			const void *blob;
+			void *ptr;
 		}v;
 
 		int count;
 		sqlite3_destructor_type destructor;
+		//the type a pointer value is bound with, a string literal
+		const char *pointerType;
 		BindValueType type;
 
 		BindValue(int i) {
@@ -65,7 +73,7 @@ namespace usql {
 			type = _USQL_ENUM_VALUE(BindValueType, IntValue);
 		}
 
-		BindValue(int64_t i64) {
+		BindValue(sqlite3_int64 i64) {
 			init();
 
 			v.i64 = i64;
@@ -79,32 +87,68 @@ namespace usql {
 			type = _USQL_ENUM_VALUE(BindValueType, DoubleValue);
 		}
 
-		BindValue(const char *str, int count, sqlite3_destructor_type destructor) {
+		BindValue(const char *str, int c, sqlite3_destructor_type d) {
 			init();
 
 			v.str = str;
-			count = count;
-			destructor = destructor;
+			count = c;
+			destructor = d;
 
 			type = _USQL_ENUM_VALUE(BindValueType, TextValue);
 		}
 
-		BindValue(const void *blob, int count, sqlite3_destructor_type destructor) {
+		BindValue(const void *blob, int c, sqlite3_destructor_type d) {
 			init();
 
 			v.blob = blob;
-			count = count;
-			destructor = destructor;
+			count = c;
+			destructor = d;
 
 			type = _USQL_ENUM_VALUE(BindValueType, BlobValue);
 		}
 
+		//count zero bytes, filled in later through a BlobStream
+		static BindValue zeroblob(int c) {
+			BindValue value;
+			value.count = c;
+			value.type = _USQL_ENUM_VALUE(BindValueType, ZeroBlobValue);
+			return value;
+		}
+
+		//an object only sqlite3_value_pointer with the same type can see, d releases it
+		static BindValue pointer(void *p, const char *type, sqlite3_destructor_type d) {
+			BindValue value;
+			value.v.ptr = p;
+			value.pointerType = type;
+			value.destructor = d;
+			value.type = _USQL_ENUM_VALUE(BindValueType, PointerValue);
+			return value;
+		}
+
+		//what sqlite would do with a pointer it can not bind
+		void releasePointer() const {
+			if (type == _USQL_ENUM_VALUE(BindValueType, PointerValue) && destructor) {
+				destructor(v.ptr);
+			}
+		}
+
+		static BindValue null() {
+			BindValue value;
+			value.type = _USQL_ENUM_VALUE(BindValueType, NullValue);
+			return value;
+		}
+
 	private:
+		BindValue() {
+			init();
+		}
+
 		void init() {
 			type = _USQL_ENUM_VALUE(BindValueType, NoneValue);
 			memset(&v, 0, sizeof(v));
 			count = -1;
 			destructor = nullptr;
+			pointerType = nullptr;
 		}
 	};
 
@@ -119,7 +163,9 @@ namespace usql {
             return _command;
         }
         
+        Result prepare();
         Result reset();
+        Result clearBindings();
         Result step();
         Result query();
         void finilize();
@@ -129,7 +175,7 @@ namespace usql {
         }
         
         inline int columnCount() const {
-            return static_cast<int>(_columns.size());
+            return _columnCount;
         }
         int columnIndexForName(const std::string &name) const;
         ColumnType typeForColumnIndex(size_t i) const;
@@ -147,7 +193,26 @@ namespace usql {
 			return fn(_stmt, idx);
 		}
 
+		template<class T>
+		DataView<T> viewForColumnIndex(int idx, ColumnType expect) {
+			if (!Statement::safeTypeCast(typeForColumnIndex(idx), expect)) {
+				return DataView<T>();
+			}
+
+			//the pointer must be fetched before the size, see sqlite3_column_bytes
+			const void *data = expect == _USQL_ENUM_VALUE(ColumnType, Text) ? static_cast<const void *>(sqlite3_column_text(_stmt, idx)) : sqlite3_column_blob(_stmt, idx);
+			size_t size = static_cast<size_t>(sqlite3_column_bytes(_stmt, idx));
+#if _USQL_VIEW_GUARD_ENABLE
+			return DataView<T>(static_cast<const T *>(data), size, _generation);
+#else
+			return DataView<T>(static_cast<const T *>(data), size);
+#endif
+		}
+
 		int parameterIndexForName(const std::string &name) const;
+		int parameterCount() const {
+			return _parametersCount;
+		}
 
 //#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
 //        template<class... TArgs>
@@ -177,12 +242,17 @@ namespace usql {
 
 		Result bindIndex(int i, const BindValue &value) {
 			if (i <= USQL_INVALID_PARAMETER_INDEX || i > _parametersCount || !_stmt) {
+				value.releasePointer();
 				return Result::error();
 			}
 
-			Result ret = reset();
-			if (!ret) {
-				return ret;
+			//parameters can only be bound before the first step, bindings survive the reset
+			if (_stepped) {
+				Result ret = reset();
+				if (!ret) {
+					value.releasePointer();
+					return ret;
+				}
 			}
 
 			if (value.type == _USQL_ENUM_VALUE(BindValueType, IntValue)) {
@@ -200,42 +270,79 @@ namespace usql {
 			else if (value.type == _USQL_ENUM_VALUE(BindValueType, BlobValue)) {
 				return Result(sqlite3_bind_blob(_stmt, i, value.v.blob, value.count, value.destructor), _db);
 			}
+			else if (value.type == _USQL_ENUM_VALUE(BindValueType, ZeroBlobValue)) {
+				return Result(sqlite3_bind_zeroblob(_stmt, i, value.count), _db);
+			}
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+			else if (value.type == _USQL_ENUM_VALUE(BindValueType, PointerValue)) {
+				return Result(sqlite3_bind_pointer(_stmt, i, value.v.ptr, value.pointerType, value.destructor), _db);
+			}
+#endif
+			else if (value.type == _USQL_ENUM_VALUE(BindValueType, NullValue)) {
+				return Result(sqlite3_bind_null(_stmt, i), _db);
+			}
 
+			value.releasePointer();
 			return Result(false);
 		}
 //#endif
         
     private:
         void initColumnInfo();
+        void invalidateRow() {
+            _hasRow = false;
+#if _USQL_VIEW_GUARD_ENABLE
+            ++(*_generation);
+#endif
+        }
+        
         void clearColumnInfo() {
+            invalidateRow();
             _columns.clear();
-            _columnTypes.clear();
+            _columnCount = 0;
+            _prepareCount = 0;
         }
         
+        bool columnInfoExpired() const;
+        //sqlite3_step that closes busy waits and waits out shared cache locks when restartable
+        int stepStatement(bool restartable);
+        
         void initParameters();
         void clearParameters() {
-            _nameParameters.clear();
+            _parameters.clear();
             _parametersCount = 0;
         }
         
-        ColumnType typeForColumn(int i);
+        static ColumnType columnType(int type);
         
         static bool safeTypeCast(ColumnType actual, ColumnType expect) {
             return actual == expect;
         }
         
-        Result prepare();
-        
     private:
         const std::string _command;
         sqlite3_stmt *_stmt;
         _WeakDatabase _db;
         
-        std::map<std::string, int> _columns;
-        std::vector<ColumnType> _columnTypes;
+        //column and parameter names are resolved once per prepare
+        NameIndex _columns;
+        int _columnCount;
+        bool _hasRow;
+        //stepped since the last reset
+        bool _stepped;
+        int _prepareCount;
+#if _USQL_VIEW_GUARD_ENABLE
+        tr1::shared_ptr<uint64_t> _generation;
+#endif
         
-        std::map<std::string, int> _nameParameters;
+        NameIndex _parameters;
         int _parametersCount;
+        
+        //links of Database's statement list
+        friend class Database;
+        Database *_registry;
+        Statement *_registryPrev;
+        Statement *_registryNext;
     };
 }
 
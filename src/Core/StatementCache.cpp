@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "StatementCache.hpp"
+#include "Utils.hpp"
+#include "Statement.hpp"
+
+namespace usql {
+    StatementCache::~StatementCache() {
+        clear();
+    }
+    
+    Statement *StatementCache::acquire(const std::string &cmd) {
+        auto iter = _index.find(cmd);
+        if (iter == _index.end()) {
+            ++_misses;
+            return new Statement(cmd, _db);
+        }
+        
+        Statement *stmt = *(iter->second);
+        _statements.erase(iter->second);
+        _index.erase(iter);
+        ++_hits;
+        
+        return stmt;
+    }
+    
+    void StatementCache::release(Statement *stmt) {
+        if (!stmt) {
+            return;
+        }
+        
+        if (_capacity == 0 || !stmt->statement() || _db.expired()) {
+            delete stmt;
+            return;
+        }
+        
+        const std::string cmd = stmt->command();
+        if (_index.find(cmd) != _index.end()) {
+            delete stmt;
+            return;
+        }
+        
+        if (!stmt->reset() || !stmt->clearBindings()) {
+            delete stmt;
+            return;
+        }
+        
+        _statements.push_front(stmt);
+        _index[cmd] = _statements.begin();
+        evict(_capacity);
+    }
+    
+    void StatementCache::clear() {
+        for (auto iter = _statements.begin(); iter != _statements.end(); ++iter) {
+            delete *iter;
+        }
+        
+        _statements.clear();
+        _index.clear();
+    }
+    
+    void StatementCache::setCapacity(size_t capacity) {
+        _capacity = capacity;
+        evict(_capacity);
+    }
+    
+    void StatementCache::evict(size_t capacity) {
+        while (_statements.size() > capacity) {
+            Statement *stmt = _statements.back();
+            _statements.pop_back();
+            _index.erase(stmt->command());
+            
+            delete stmt;
+            ++_evictions;
+        }
+    }
+}
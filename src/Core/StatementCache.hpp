@@ -0,0 +1,113 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef StatementCache_hpp
+#define StatementCache_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Database.hpp"
+
+namespace usql {
+    class Statement;
+    class StatementCache;
+    typedef tr1::shared_ptr<StatementCache> _StatementCache;
+    typedef tr1::weak_ptr<StatementCache> _WeakStatementCache;
+    
+    //LRU cache of prepared statements keyed by sql text
+    class StatementCache : public NoCopyable
+    {
+    public:
+        static _StatementCache create(_WeakDatabase db, size_t capacity = USQL_DEFAULT_STATEMENT_CACHE_CAPACITY) {
+            return tr1::shared_ptr<StatementCache>(new StatementCache(db, capacity));
+        }
+        
+        ~StatementCache();
+        
+        //returns a reset statement with cleared bindings, the caller owns it until release()
+        Statement *acquire(const std::string &cmd);
+        //gives the statement back to the cache, it is deleted if it can not be reused
+        void release(Statement *stmt);
+        
+        //finalize and delete all idle statements
+        void clear();
+        
+        void setCapacity(size_t capacity);
+        size_t capacity() const {
+            return _capacity;
+        }
+        
+        size_t size() const {
+            return _statements.size();
+        }
+        
+        uint64_t hits() const {
+            return _hits;
+        }
+        
+        uint64_t misses() const {
+            return _misses;
+        }
+        
+        uint64_t evictions() const {
+            return _evictions;
+        }
+        
+        void resetStats() {
+            _hits = 0;
+            _misses = 0;
+            _evictions = 0;
+        }
+        
+    private:
+        StatementCache(_WeakDatabase db, size_t capacity)
+        : _db(db)
+        , _capacity(capacity)
+        , _hits(0)
+        , _misses(0)
+        , _evictions(0) {}
+        
+        void evict(size_t capacity);
+        
+    private:
+        typedef std::list<Statement *> _StatementList;
+        
+        _WeakDatabase _db;
+        size_t _capacity;
+        
+        //front is the most recently used
+        _StatementList _statements;
+        std::map<std::string, _StatementList::iterator> _index;
+        
+        uint64_t _hits;
+        uint64_t _misses;
+        uint64_t _evictions;
+    };
+}
+
+#endif /* StatementCache_hpp */
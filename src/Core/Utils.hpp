@@ -43,6 +43,17 @@ namespace usql {
     {
     public:
         static std::time_t str2tm(const std::string &str);
+        
+        //FNV-1a
+        static uint32_t hash(const char *str, size_t len) {
+            uint32_t h = 2166136261u;
+            for (size_t i = 0; i < len; ++i) {
+                h ^= static_cast<unsigned char>(str[i]);
+                h *= 16777619u;
+            }
+            
+            return h;
+        }
     };
 }
 
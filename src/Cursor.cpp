@@ -28,6 +28,8 @@
 #include "Utils.hpp"
 #include "Statement.hpp"
 #include "Connection.hpp"
+#include "ArrayTable.hpp"
+#include <cstring>
 
 namespace usql {
     static inline sqlite3_destructor_type bindValueDestructorType(BindType type) {
@@ -48,15 +50,36 @@ namespace usql {
         return t;
     }
     
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+    static inline BindValue arrayBindValue(ArrayValues *values) {
+        return BindValue::pointer(values, ArrayTable::pointerType(), ArrayValues::release);
+    }
+#endif
+    
     Cursor::Cursor(const std::string &cmd, Connection &db)
-    : _stmt(nullptr) {
-        _stmt = new Statement(cmd, db.database());
-        _stmt->reset();
+    : _stmt(nullptr)
+    , _cache(db.statementCache()) {
+        _stmt = _cache.lock()->acquire(cmd);
+        //cached statements come back reset, fresh ones only need preparing
+        _stmt->prepare();
     }
     
     Cursor::~Cursor() {
-        close();
-        delete _stmt;
+        if (_cache.expired()) {
+            close();
+            delete _stmt;
+        }
+        else {
+            _cache.lock()->release(_stmt);
+        }
+    }
+    
+    Parameter Cursor::parameter(const std::string &name) const {
+        return Parameter(_stmt->parameterIndexForName(name));
+    }
+    
+    int Cursor::parameterCount() const {
+        return _stmt->parameterCount();
     }
     
     void Cursor::close() {
@@ -87,6 +110,44 @@ namespace usql {
         return _stmt->bindName(key, BindValue(blob, count, bindValueDestructorType(opt)));
     }
     
+    Result Cursor::bind(const std::string &key, const TextView &value, BindType opt) {
+        return bind(_stmt->parameterIndexForName(key), value, opt);
+    }
+    
+    Result Cursor::bind(const std::string &key, const BlobView &value, BindType opt) {
+        return bind(_stmt->parameterIndexForName(key), value, opt);
+    }
+    
+    Result Cursor::bindNull(const std::string &key) {
+        return _stmt->bindName(key, BindValue::null());
+    }
+    
+    Result Cursor::bindZeroBlob(const std::string &key, int count) {
+        if (count < 0) {
+            return false;
+        }
+        
+        return _stmt->bindName(key, BindValue::zeroblob(count));
+    }
+    
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+    Result Cursor::bind(const std::string &key, const std::vector<int> &values) {
+        return _stmt->bindName(key, arrayBindValue(ArrayValues::create(values)));
+    }
+    
+    Result Cursor::bind(const std::string &key, const std::vector<int64_t> &values) {
+        return _stmt->bindName(key, arrayBindValue(ArrayValues::create(values)));
+    }
+    
+    Result Cursor::bind(const std::string &key, const std::vector<double> &values) {
+        return _stmt->bindName(key, arrayBindValue(ArrayValues::create(values)));
+    }
+    
+    Result Cursor::bind(const std::string &key, const std::vector<std::string> &values) {
+        return _stmt->bindName(key, arrayBindValue(ArrayValues::create(values)));
+    }
+#endif
+    
     Result Cursor::bind(int index, int value) {
         return _stmt->bindIndex(index, BindValue(value));
     }
@@ -111,6 +172,60 @@ namespace usql {
         return _stmt->bindIndex(index, BindValue(blob, count, bindValueDestructorType(opt)));
     }
     
+    Result Cursor::bind(int index, const TextView &value, BindType opt) {
+        if (value.isNull()) {
+            return bindNull(index);
+        }
+        
+        return _stmt->bindIndex(index, BindValue(value.data(), static_cast<int>(value.size()), bindValueDestructorType(opt)));
+    }
+    
+    Result Cursor::bind(int index, const BlobView &value, BindType opt) {
+        if (value.isNull()) {
+            return bindNull(index);
+        }
+        
+        return _stmt->bindIndex(index, BindValue(static_cast<const void *>(value.data()), static_cast<int>(value.size()), bindValueDestructorType(opt)));
+    }
+    
+    Result Cursor::bindNull(int index) {
+        return _stmt->bindIndex(index, BindValue::null());
+    }
+    
+    Result Cursor::bindZeroBlob(int index, int count) {
+        if (count < 0) {
+            return false;
+        }
+        
+        return _stmt->bindIndex(index, BindValue::zeroblob(count));
+    }
+    
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+    Result Cursor::bind(int index, const std::vector<int> &values) {
+        return _stmt->bindIndex(index, arrayBindValue(ArrayValues::create(values)));
+    }
+    
+    Result Cursor::bind(int index, const std::vector<int64_t> &values) {
+        return _stmt->bindIndex(index, arrayBindValue(ArrayValues::create(values)));
+    }
+    
+    Result Cursor::bind(int index, const std::vector<double> &values) {
+        return _stmt->bindIndex(index, arrayBindValue(ArrayValues::create(values)));
+    }
+    
+    Result Cursor::bind(int index, const std::vector<std::string> &values) {
+        return _stmt->bindIndex(index, arrayBindValue(ArrayValues::create(values)));
+    }
+#endif
+    
+    Result Cursor::bindValue(BindType opt, int idx, const char *value) {
+        if (!value) {
+            return bindNull(idx);
+        }
+        
+        return bind(idx, TextView(value, std::strlen(value)), opt);
+    }
+    
     Result Cursor::exec() {
         return _stmt->step();
     }
@@ -31,10 +31,37 @@
 #include "USQLDefs.hpp"
 #include "Object.hpp"
 #include "Result.hpp"
+#include "DataView.hpp"
+#include "StatementCache.hpp"
 
 namespace usql {
     class Connection;
     class Statement;
+    
+    //a named parameter resolved to its index, binds without a name lookup;
+    //the index only depends on the sql text, so a handle can be kept for every cursor of that text
+    class Parameter
+    {
+    public:
+        Parameter() : _index(USQL_INVALID_PARAMETER_INDEX) {}
+        explicit Parameter(int index) : _index(index) {}
+        
+        int index() const {
+            return _index;
+        }
+        
+        bool valid() const {
+            return _index > USQL_INVALID_PARAMETER_INDEX;
+        }
+        
+        operator int() const {
+            return _index;
+        }
+        
+    private:
+        int _index;
+    };
+    
     class Cursor : public NoCopyable
     {
     public:
@@ -42,24 +69,143 @@ namespace usql {
         
         virtual ~Cursor();
         
+        //invalid if the statement has no parameter with that name, e.g. ":a", "@a" or "$a"
+        Parameter parameter(const std::string &name) const;
+        int parameterCount() const;
+        
         Result bind(const std::string &key, int value);
         Result bind(const std::string &key, sqlite3_int64 value);
         Result bind(const std::string &key, double value);
         Result bind(const std::string &key, const std::string &value, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
         Result bind(const std::string &key, const void *blob, int count, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
+        Result bind(const std::string &key, const TextView &value, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
+        Result bind(const std::string &key, const BlobView &value, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
+        Result bindNull(const std::string &key);
+        //preallocates a blob of count zero bytes to be streamed in with BlobStream
+        Result bindZeroBlob(const std::string &key, int count);
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+        //binds a copy of the list as the table valued parameter of usql_array, see ArrayTable;
+        //"where id in usql_array(?)" serves lists of any size with one prepared statement
+        Result bind(const std::string &key, const std::vector<int> &values);
+        Result bind(const std::string &key, const std::vector<int64_t> &values);
+        Result bind(const std::string &key, const std::vector<double> &values);
+        Result bind(const std::string &key, const std::vector<std::string> &values);
+#endif
         
         Result bind(int index, int value);
         Result bind(int index, sqlite3_int64 value);
         Result bind(int index, double value);
         Result bind(int index, const std::string &value, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
         Result bind(int index, const void *blob, int count, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
+        Result bind(int index, const TextView &value, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
+        Result bind(int index, const BlobView &value, BindType opt = _USQL_ENUM_VALUE(BindType, Copy));
+        Result bindNull(int index);
+        Result bindZeroBlob(int index, int count);
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+        Result bind(int index, const std::vector<int> &values);
+        Result bind(int index, const std::vector<int64_t> &values);
+        Result bind(int index, const std::vector<double> &values);
+        Result bind(int index, const std::vector<std::string> &values);
+#endif
+        
+        //binds the values to parameters 1...n, the statement is reset at most once per execution;
+        //text and blobs are copied by bindAll and referenced by bindAllStatic
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+        template<class... TArgs>
+        Result bindAll(const TArgs&... values) {
+            return bindValues(_USQL_ENUM_VALUE(BindType, Copy), 1, values...);
+        }
+        
+        template<class... TArgs>
+        Result bindAll(const tr1::tuple<TArgs...> &values) {
+            return bindTuple(_USQL_ENUM_VALUE(BindType, Copy), values, typename IndexSequence<sizeof...(TArgs)>::type());
+        }
+        
+        //the values must outlive the execution
+        template<class... TArgs>
+        Result bindAllStatic(const TArgs&... values) {
+            return bindValues(_USQL_ENUM_VALUE(BindType, Static), 1, values...);
+        }
+        
+        template<class... TArgs>
+        Result bindAllStatic(const tr1::tuple<TArgs...> &values) {
+            return bindTuple(_USQL_ENUM_VALUE(BindType, Static), values, typename IndexSequence<sizeof...(TArgs)>::type());
+        }
+#endif
 
         Result exec();
         
         void close();
         
+    private:
+        Result bindValue(BindType opt, int idx, const std::string &value) {
+            return bind(idx, TextView(value.data(), value.size()), opt);
+        }
+        
+        Result bindValue(BindType opt, int idx, const char *value);
+        
+        Result bindValue(BindType opt, int idx, const TextView &value) {
+            return bind(idx, value, opt);
+        }
+        
+        Result bindValue(BindType opt, int idx, const BlobView &value) {
+            return bind(idx, value, opt);
+        }
+        
+        Result bindValue(BindType, int idx, bool value) {
+            return bind(idx, value ? 1 : 0);
+        }
+        
+        template<class T>
+        typename tr1::enable_if<tr1::is_integral<T>::value && (sizeof(T) <= sizeof(int)), Result>::type bindValue(BindType, int idx, T value) {
+            return bind(idx, static_cast<int>(value));
+        }
+        
+        template<class T>
+        typename tr1::enable_if<tr1::is_integral<T>::value && (sizeof(T) > sizeof(int)), Result>::type bindValue(BindType, int idx, T value) {
+            return bind(idx, static_cast<sqlite3_int64>(value));
+        }
+        
+        template<class T>
+        typename tr1::enable_if<tr1::is_floating_point<T>::value, Result>::type bindValue(BindType, int idx, T value) {
+            return bind(idx, static_cast<double>(value));
+        }
+        
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+        Result bindValue(BindType, int idx, std::nullptr_t) {
+            return bindNull(idx);
+        }
+        
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+        template<class T>
+        Result bindValue(BindType, int idx, const std::vector<T> &values) {
+            return bind(idx, values);
+        }
+#endif
+        
+        Result bindValues(BindType, int) {
+            return Result::success();
+        }
+        
+        template<class T, class... TArgs>
+        Result bindValues(BindType opt, int idx, const T &value, const TArgs&... values) {
+            Result ret = bindValue(opt, idx, value);
+            if (!ret) {
+                return ret;
+            }
+            
+            return bindValues(opt, idx + 1, values...);
+        }
+        
+        template<class... TArgs, size_t... I>
+        Result bindTuple(BindType opt, const tr1::tuple<TArgs...> &values, Indexes<I...>) {
+            return bindValues(opt, 1, tr1::get<I>(values)...);
+        }
+#endif
+        
     protected:
         Statement *_stmt;
+        _WeakStatementCache _cache;
     };
 }
 
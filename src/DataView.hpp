@@ -0,0 +1,107 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef DataView_hpp
+#define DataView_hpp
+
+#include "StdCpp.hpp"
+
+namespace usql {
+    //non-owning view of a column value, valid until the next next()/reset() of its query
+    template<class T>
+    class DataView
+    {
+    public:
+        DataView() : _data(nullptr), _size(0) {}
+        
+#if _USQL_VIEW_GUARD_ENABLE
+        DataView(const T *data, size_t size) : _data(data), _size(size), _expect(0) {}
+        
+        DataView(const T *data, size_t size, tr1::shared_ptr<const uint64_t> generation)
+        : _data(data)
+        , _size(size)
+        , _generation(generation)
+        , _expect(generation ? *generation : 0) {}
+#else
+        DataView(const T *data, size_t size) : _data(data), _size(size) {}
+#endif
+        
+        const T *data() const {
+            assert(valid() && "usql: column view used after next() or reset()");
+            return _data;
+        }
+        
+        size_t size() const {
+            return _size;
+        }
+        
+        bool empty() const {
+            return _size == 0;
+        }
+        
+        //a null, type mismatched or zero length blob column has no data
+        bool isNull() const {
+            return _data == nullptr;
+        }
+        
+        const T *begin() const {
+            return data();
+        }
+        
+        const T *end() const {
+            return data() + _size;
+        }
+        
+        std::string str() const {
+            const T *p = data();
+            return p ? std::string(reinterpret_cast<const char *>(p), _size) : std::string();
+        }
+        
+        //always true in release builds
+        bool valid() const {
+#if _USQL_VIEW_GUARD_ENABLE
+            return !_generation || *_generation == _expect;
+#else
+            return true;
+#endif
+        }
+        
+    private:
+        const T *_data;
+        size_t _size;
+        
+#if _USQL_VIEW_GUARD_ENABLE
+        tr1::shared_ptr<const uint64_t> _generation;
+        uint64_t _expect;
+#endif
+    };
+    
+    typedef DataView<char> TextView;
+    typedef DataView<unsigned char> BlobView;
+}
+
+#endif /* DataView_hpp */
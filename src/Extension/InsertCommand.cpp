@@ -25,6 +25,9 @@
  **/
 
 #include "InsertCommand.hpp"
+#include "Cursor.hpp"
+#include "Connection.hpp"
+#include "Transaction.hpp"
 
 namespace usql {
     InsertCommand &InsertCommand::expr(const std::string &name, const std::string &e) {
@@ -65,4 +68,146 @@ namespace usql {
         buf<<"INSERT INTO "<<tablename()<<" ("<<names.str()<<") VALUES ("<<values.str()<<")";
         return buf.str();
     }
+    
+    InsertCommand &InsertCommand::columns(const std::vector<std::string> &names) {
+        _names = names;
+        _values.clear();
+        _invalidRows = 0;
+        return *this;
+    }
+    
+    size_t InsertCommand::rowsPerChunk() const {
+        if (_names.empty()) {
+            return 0;
+        }
+        
+        return std::max<size_t>(1, static_cast<size_t>(_maxVariables) / _names.size());
+    }
+    
+    size_t InsertCommand::chunkCount() const {
+        size_t rows = rowCount();
+        if (rows == 0) {
+            return 0;
+        }
+        
+        size_t per = rowsPerChunk();
+        return (rows + per - 1) / per;
+    }
+    
+    std::string InsertCommand::chunkCommand(size_t chunk) const {
+        if (chunk >= chunkCount()) {
+            return "";
+        }
+        
+        size_t per = rowsPerChunk();
+        size_t rows = std::min(per, rowCount() - chunk * per);
+        
+        std::string names;
+        std::string placeholders = "(";
+        for (size_t i = 0; i < _names.size(); ++i) {
+            if (i) {
+                names.append(", ");
+                placeholders.append(", ");
+            }
+            
+            names.append(_names[i]);
+            placeholders.append("?");
+        }
+        placeholders.append(")");
+        
+        std::string buf = "INSERT INTO " + tablename() + " (" + names + ") VALUES ";
+        buf.reserve(buf.size() + rows * (placeholders.size() + 2));
+        for (size_t r = 0; r < rows; ++r) {
+            if (r) {
+                buf.append(", ");
+            }
+            
+            buf.append(placeholders);
+        }
+        
+        return buf;
+    }
+    
+    Result InsertCommand::bindChunk(Cursor &cursor, size_t chunk) const {
+        if (_invalidRows > 0) {
+            return Result(SQLITE_MISUSE, _USQL_SQLITE_ERRSTR(SQLITE_MISUSE));
+        }
+        
+        if (chunk >= chunkCount()) {
+            return Result::error();
+        }
+        
+        size_t per = rowsPerChunk() * _names.size();
+        size_t first = chunk * per;
+        size_t last = std::min(_values.size(), first + per);
+        for (size_t i = first; i < last; ++i) {
+            const Value &value = _values[i];
+            int idx = static_cast<int>(i - first + 1);
+            Result ret(true);
+            if (value.type == _USQL_ENUM_VALUE(ColumnType, Integer)) {
+                ret = cursor.bind(idx, static_cast<sqlite3_int64>(value.i));
+            }
+            else if (value.type == _USQL_ENUM_VALUE(ColumnType, Float)) {
+                ret = cursor.bind(idx, value.d);
+            }
+            else if (value.type == _USQL_ENUM_VALUE(ColumnType, Text)) {
+                ret = cursor.bind(idx, TextView(value.s.data(), value.s.size()), _USQL_ENUM_VALUE(BindType, Static));
+            }
+            else {
+                ret = cursor.bindNull(idx);
+            }
+            
+            if (!ret) {
+                return ret;
+            }
+        }
+        
+        return Result::success();
+    }
+    
+    Result InsertCommand::exec(Connection &con) const {
+        if (_invalidRows > 0) {
+            return Result(SQLITE_MISUSE, _USQL_SQLITE_ERRSTR(SQLITE_MISUSE));
+        }
+        
+        size_t count = chunkCount();
+        if (count == 0) {
+            return false;
+        }
+        
+        //a single chunk is already atomic
+        if (count == 1) {
+            return execChunks(con, count);
+        }
+        
+        //rolled back on destruction unless committed
+        Transaction transaction(con, _USQL_ENUM_VALUE(TransactionType, Immediate));
+        if (!transaction.isActive()) {
+            return transaction.beginResult();
+        }
+        
+        Result ret = execChunks(con, count);
+        if (!ret) {
+            return ret;
+        }
+        
+        return transaction.commit();
+    }
+    
+    Result InsertCommand::execChunks(Connection &con, size_t count) const {
+        for (size_t i = 0; i < count; ++i) {
+            Cursor cursor(chunkCommand(i), con);
+            Result ret = bindChunk(cursor, i);
+            if (!ret) {
+                return ret;
+            }
+            
+            ret = cursor.exec();
+            if (!ret) {
+                return ret;
+            }
+        }
+        
+        return Result::success();
+    }
 }
\ No newline at end of file
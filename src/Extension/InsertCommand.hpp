@@ -28,13 +28,17 @@
 #define InsertCommand_hpp
 
 #include "Command.hpp"
+#include "Result.hpp"
 
 namespace usql {
+    class Connection;
+    class Cursor;
+    
     class InsertCommand : Command<InsertCommand>
     {
     public:
         //using Command::Command;
-		InsertCommand(const std::string &tablename): Command(tablename) {}
+		InsertCommand(const std::string &tablename): Command(tablename), _invalidRows(0), _maxVariables(USQL_DEFAULT_MAX_VARIABLE_NUMBER) {}
         
         virtual std::string command() const override;
         
@@ -55,8 +59,125 @@ namespace usql {
         
         InsertCommand &expr(const std::string &name, const std::string &e);
         
+    public:
+        //multi-row insert with parameter placeholders:
+        //rows are split into chunks of VALUES (?, ?), (?, ?), ... that stay under maxVariables parameters
+        InsertCommand &columns(const std::vector<std::string> &names);
+        
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+        //a row that does not match columns() is not added, exec() and bindChunk() then fail with SQLITE_MISUSE
+        template<class... TArgs>
+        InsertCommand &row(const TArgs&... values) {
+            if (sizeof...(TArgs) != _names.size() || _names.empty()) {
+                ++_invalidRows;
+                return *this;
+            }
+            
+            appendValues(values...);
+            return *this;
+        }
+#endif
+        
+        InsertCommand &setMaxVariables(int count) {
+            _maxVariables = std::max(1, count);
+            return *this;
+        }
+        int maxVariables() const {
+            return _maxVariables;
+        }
+        
+        size_t rowCount() const {
+            return _names.empty() ? 0 : _values.size() / _names.size();
+        }
+        
+        //rows rejected by row() since the last columns() or clearRows()
+        size_t invalidRowCount() const {
+            return _invalidRows;
+        }
+        
+        void clearRows() {
+            _values.clear();
+            _invalidRows = 0;
+        }
+        
+        size_t rowsPerChunk() const;
+        size_t chunkCount() const;
+        std::string chunkCommand(size_t chunk) const;
+        //binds the values of the chunk in placeholder order, they must outlive the execution
+        Result bindChunk(Cursor &cursor, size_t chunk) const;
+        
+        //executes every chunk, full chunks share one cached statement;
+        //several chunks run in one Transaction so a failing chunk leaves none of the rows
+        Result exec(Connection &con) const;
+        
+    private:
+        Result execChunks(Connection &con, size_t count) const;
+        
+    private:
+        struct Value
+        {
+            ColumnType type;
+            int64_t i;
+            double d;
+            std::string s;
+            
+            Value() : type(_USQL_ENUM_VALUE(ColumnType, Null)), i(0), d(0) {}
+        };
+        
+        template<class T>
+        typename tr1::enable_if<tr1::is_integral<T>::value>::type appendValue(T v) {
+            Value value;
+            value.type = _USQL_ENUM_VALUE(ColumnType, Integer);
+            value.i = static_cast<int64_t>(v);
+            _values.push_back(value);
+        }
+        
+        template<class T>
+        typename tr1::enable_if<tr1::is_floating_point<T>::value>::type appendValue(T v) {
+            Value value;
+            value.type = _USQL_ENUM_VALUE(ColumnType, Float);
+            value.d = static_cast<double>(v);
+            _values.push_back(value);
+        }
+        
+        void appendValue(const std::string &v) {
+            Value value;
+            value.type = _USQL_ENUM_VALUE(ColumnType, Text);
+            value.s = v;
+            _values.push_back(value);
+        }
+        
+        void appendValue(const char *v) {
+            if (!v) {
+                _values.push_back(Value());
+                return;
+            }
+            
+            appendValue(std::string(v));
+        }
+        
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+        void appendValue(std::nullptr_t) {
+            _values.push_back(Value());
+        }
+        
+        void appendValues() {
+        }
+        
+        template<class T, class... TArgs>
+        void appendValues(const T &value, const TArgs&... values) {
+            appendValue(value);
+            appendValues(values...);
+        }
+#endif
+        
     private:
         std::map<std::string, std::string> _column;
+        
+        std::vector<std::string> _names;
+        std::vector<Value> _values;
+        size_t _invalidRows;
+        int _maxVariables;
     };
 }
 
@@ -29,9 +29,45 @@
 #include "StdCpp.hpp"
 #include "Object.hpp"
 #include "USQLDefs.hpp"
+#include "DataView.hpp"
+#include <exception>
+#include <new>
 
 namespace usql {
+    //the arguments of one call, a view of sqlite's argv that allocates nothing
+    class FunctionArguments
+    {
+    public:
+        FunctionArguments(sqlite3_value **argv, int argc) : _argv(argv), _argc(argc > 0 ? argc : 0) {}
+        
+        size_t size() const {
+            return _argc;
+        }
+        
+        bool empty() const {
+            return _argc == 0;
+        }
+        
+        sqlite3_value *operator[](size_t i) const {
+            assert(i < _argc && "usql: function argument out of range");
+            return _argv[i];
+        }
+        
+        sqlite3_value *const *begin() const {
+            return _argv;
+        }
+        
+        sqlite3_value *const *end() const {
+            return _argv + _argc;
+        }
+        
+    private:
+        sqlite3_value **_argv;
+        size_t _argc;
+    };
+    
     typedef tr1::function<void(sqlite3_context*, std::vector<sqlite3_value *> &)> sqlite_step_func;
+    typedef tr1::function<void(sqlite3_context*, const FunctionArguments &)> sqlite_arguments_func;
     typedef tr1::function<void(sqlite3_context *)> sqlite_final_func;
     
     class Function : public NoCopyable
@@ -47,6 +83,11 @@ namespace usql {
                 return;
             }
             
+            if (obj->_argumentsFunc) {
+                obj->_argumentsFunc(context, FunctionArguments(argv, argc));
+                return;
+            }
+            
             std::vector<sqlite3_value *> list;
             for (int i = 0; i < argc; ++i) {
                 list.push_back(argv[i]);
@@ -62,10 +103,16 @@ namespace usql {
             delete obj;
         }
         
+        //copies argv into a new vector on every call, see setArgumentsFunction
         void setFunction(sqlite_step_func func) {
             _func = func;
         }
         
+        //takes precedence over setFunction, the arguments are passed without a copy
+        void setArgumentsFunction(sqlite_arguments_func func) {
+            _argumentsFunc = func;
+        }
+        
         void setArgumentCount(int num) {
             _argumentCount = std::max(-1, num);
         }
@@ -82,6 +129,7 @@ namespace usql {
         
         int _argumentCount;
         sqlite_step_func _func;
+        sqlite_arguments_func _argumentsFunc;
     };
     
     class AggregateFunction : public Function
@@ -114,6 +162,376 @@ namespace usql {
         
         sqlite_final_func _final;
     };
+    
+#if _USQL_SQLITE_WINDOW_FUNCTION_ENABLE
+    //an aggregate that also runs as a window function in O(1) per row: value reports the
+    //current frame without finishing it, inverse removes the row that left the frame
+    class WindowFunction : public AggregateFunction
+    {
+    public:
+        static WindowFunction *create(const std::string &name) {
+            return new WindowFunction(name);
+        }
+        
+        void setValueFunction(sqlite_final_func func) {
+            _value = func;
+        }
+        
+        void setInverseFunction(sqlite_arguments_func func) {
+            _inverse = func;
+        }
+        
+        static void xValue(sqlite3_context* context) {
+            WindowFunction *obj = static_cast<WindowFunction *>(sqlite3_user_data(context));
+            if(!obj) {
+                return;
+            }
+            
+            if (obj->_value) {
+                obj->_value(context);
+            }
+        }
+        
+        static void xInverse(sqlite3_context* context, int argc, sqlite3_value** argv) {
+            WindowFunction *obj = static_cast<WindowFunction *>(sqlite3_user_data(context));
+            if(!obj) {
+                return;
+            }
+            
+            if (obj->_inverse) {
+                obj->_inverse(context, FunctionArguments(argv, argc));
+            }
+        }
+        
+    protected:
+        WindowFunction(const std::string &name): AggregateFunction(name) {}
+        
+        sqlite_final_func _value;
+        sqlite_arguments_func _inverse;
+    };
+#endif
+    
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+    //decodes an argument with sqlite's conversions, NULL becomes 0 or an empty view;
+    //views point into the argument and are valid until the function returns
+    template<class T, class Enable = void>
+    struct FunctionArgument;
+    
+    template<class T>
+    struct FunctionArgument<T, typename tr1::enable_if<tr1::is_integral<T>::value>::type> {
+        //the same split as FunctionResult, so an unsigned int above INT_MAX round-trips through int64
+        static T get(sqlite3_value *value) {
+            if (sizeof(T) < sizeof(int) || (sizeof(T) == sizeof(int) && tr1::is_signed<T>::value)) {
+                return static_cast<T>(sqlite3_value_int(value));
+            }
+            
+            return static_cast<T>(sqlite3_value_int64(value));
+        }
+    };
+    
+    template<>
+    struct FunctionArgument<bool> {
+        static bool get(sqlite3_value *value) {
+            return sqlite3_value_int64(value) != 0;
+        }
+    };
+    
+    template<class T>
+    struct FunctionArgument<T, typename tr1::enable_if<tr1::is_floating_point<T>::value>::type> {
+        static T get(sqlite3_value *value) {
+            return static_cast<T>(sqlite3_value_double(value));
+        }
+    };
+    
+    template<>
+    struct FunctionArgument<TextView> {
+        static TextView get(sqlite3_value *value) {
+            const char *text = reinterpret_cast<const char *>(sqlite3_value_text(value));
+            return text ? TextView(text, static_cast<size_t>(sqlite3_value_bytes(value))) : TextView();
+        }
+    };
+    
+    template<>
+    struct FunctionArgument<BlobView> {
+        static BlobView get(sqlite3_value *value) {
+            const unsigned char *blob = static_cast<const unsigned char *>(sqlite3_value_blob(value));
+            return blob ? BlobView(blob, static_cast<size_t>(sqlite3_value_bytes(value))) : BlobView();
+        }
+    };
+    
+    template<>
+    struct FunctionArgument<std::string> {
+        static std::string get(sqlite3_value *value) {
+            const char *text = reinterpret_cast<const char *>(sqlite3_value_text(value));
+            return text ? std::string(text, static_cast<size_t>(sqlite3_value_bytes(value))) : std::string();
+        }
+    };
+    
+    template<>
+    struct FunctionArgument<sqlite3_value *> {
+        static sqlite3_value *get(sqlite3_value *value) {
+            return value;
+        }
+    };
+    
+    //sets the function result from a returned value, text and blobs are copied by sqlite
+    template<class T, class Enable = void>
+    struct FunctionResult;
+    
+    template<class T>
+    struct FunctionResult<T, typename tr1::enable_if<tr1::is_integral<T>::value>::type> {
+        static void set(sqlite3_context *context, T value) {
+            if (sizeof(T) < sizeof(int) || (sizeof(T) == sizeof(int) && tr1::is_signed<T>::value)) {
+                sqlite3_result_int(context, static_cast<int>(value));
+            }
+            else {
+                sqlite3_result_int64(context, static_cast<sqlite3_int64>(value));
+            }
+        }
+    };
+    
+    template<class T>
+    struct FunctionResult<T, typename tr1::enable_if<tr1::is_floating_point<T>::value>::type> {
+        static void set(sqlite3_context *context, T value) {
+            sqlite3_result_double(context, static_cast<double>(value));
+        }
+    };
+    
+    template<>
+    struct FunctionResult<std::string> {
+        static void set(sqlite3_context *context, const std::string &value) {
+            sqlite3_result_text(context, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+        }
+    };
+    
+    template<>
+    struct FunctionResult<const char *> {
+        static void set(sqlite3_context *context, const char *value) {
+            if (value) {
+                sqlite3_result_text(context, value, -1, SQLITE_TRANSIENT);
+            }
+            else {
+                sqlite3_result_null(context);
+            }
+        }
+    };
+    
+    template<>
+    struct FunctionResult<TextView> {
+        static void set(sqlite3_context *context, const TextView &value) {
+            if (value.isNull()) {
+                sqlite3_result_null(context);
+            }
+            else {
+                sqlite3_result_text(context, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+            }
+        }
+    };
+    
+    template<>
+    struct FunctionResult<BlobView> {
+        static void set(sqlite3_context *context, const BlobView &value) {
+            if (value.isNull()) {
+                sqlite3_result_null(context);
+            }
+            else {
+                sqlite3_result_blob(context, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+            }
+        }
+    };
+    
+    template<>
+    struct FunctionResult<std::nullptr_t> {
+        static void set(sqlite3_context *context, std::nullptr_t) {
+            sqlite3_result_null(context);
+        }
+    };
+    
+    //calls func with the decoded arguments and sets its result, a void function returns NULL
+    template<class R>
+    struct FunctionCall {
+        template<class F, class... TArgs>
+        static void invoke(sqlite3_context *context, F &func, TArgs&&... args) {
+            FunctionResult<typename tr1::decay<R>::type>::set(context, func(std::forward<TArgs>(args)...));
+        }
+    };
+    
+    template<>
+    struct FunctionCall<void> {
+        template<class F, class... TArgs>
+        static void invoke(sqlite3_context *, F &func, TArgs&&... args) {
+            func(std::forward<TArgs>(args)...);
+        }
+    };
+    
+    //scalar function with a fixed signature, e.g. TypedFunction<F, double(double, double)>;
+    //arguments and result are converted at compile time, a call allocates nothing
+    template<class F, class Signature>
+    class TypedFunction;
+    
+    template<class F, class R, class... TArgs>
+    class TypedFunction<F, R(TArgs...)> : public NoCopyable
+    {
+    public:
+        TypedFunction(const F &func) : _func(func) {}
+        
+        static int argumentCount() {
+            return static_cast<int>(sizeof...(TArgs));
+        }
+        
+        static void xFunc(sqlite3_context *context, int, sqlite3_value **argv) {
+            TypedFunction *obj = static_cast<TypedFunction *>(sqlite3_user_data(context));
+            try {
+                call(context, obj->_func, argv, typename IndexSequence<sizeof...(TArgs)>::type());
+            }
+            catch (const std::exception &e) {
+                sqlite3_result_error(context, e.what(), -1);
+            }
+        }
+        
+        static void xDestroy(void *p) {
+            delete static_cast<TypedFunction *>(p);
+        }
+        
+    private:
+        template<size_t... I>
+        static void call(sqlite3_context *context, F &func, sqlite3_value **argv, Indexes<I...>) {
+            FunctionCall<R>::invoke(context, func, FunctionArgument<typename tr1::decay<TArgs>::type>::get(argv[I])...);
+        }
+        
+    private:
+        F _func;
+    };
+    
+    //aggregate whose accumulator lives in sqlite3_aggregate_context memory, one State per group:
+    //a copy of the prototype is placement-constructed on the first row of a group, State::step(args...)
+    //takes each row and State::value() is the result; the state is destroyed once the group
+    //is finished or abandoned. State::inverse(args...) is only needed by window functions
+    template<class State, class Step = decltype(&State::step)>
+    class TypedAggregate;
+    
+    template<class State, class R, class... TArgs>
+    class TypedAggregate<State, R (State::*)(TArgs...)> : public NoCopyable
+    {
+    public:
+        TypedAggregate(const State &prototype) : _prototype(prototype) {}
+        
+        static int argumentCount() {
+            return static_cast<int>(sizeof...(TArgs));
+        }
+        
+        static void xStep(sqlite3_context *context, int, sqlite3_value **argv) {
+            try {
+                State *state = stateForContext(context);
+                if (state) {
+                    step(*state, argv, typename IndexSequence<sizeof...(TArgs)>::type());
+                }
+            }
+            catch (const std::exception &e) {
+                sqlite3_result_error(context, e.what(), -1);
+            }
+        }
+        
+        static void xFinal(sqlite3_context *context) {
+            Slot *slot = static_cast<Slot *>(sqlite3_aggregate_context(context, 0));
+            State *state = slot && slot->constructed ? reinterpret_cast<State *>(&slot->storage) : nullptr;
+            try {
+                if (state) {
+                    result(context, *state);
+                }
+                else {
+                    //a group without rows
+                    State empty(static_cast<TypedAggregate *>(sqlite3_user_data(context))->_prototype);
+                    result(context, empty);
+                }
+            }
+            catch (const std::exception &e) {
+                sqlite3_result_error(context, e.what(), -1);
+            }
+            
+            if (state) {
+                state->~State();
+                slot->constructed = false;
+            }
+        }
+        
+        //the result so far, the group goes on
+        static void xValue(sqlite3_context *context) {
+            Slot *slot = static_cast<Slot *>(sqlite3_aggregate_context(context, 0));
+            try {
+                if (slot && slot->constructed) {
+                    result(context, *reinterpret_cast<State *>(&slot->storage));
+                }
+                else {
+                    State empty(static_cast<TypedAggregate *>(sqlite3_user_data(context))->_prototype);
+                    result(context, empty);
+                }
+            }
+            catch (const std::exception &e) {
+                sqlite3_result_error(context, e.what(), -1);
+            }
+        }
+        
+        //takes back a row added by step
+        static void xInverse(sqlite3_context *context, int, sqlite3_value **argv) {
+            try {
+                State *state = stateForContext(context);
+                if (state) {
+                    inverse(*state, argv, typename IndexSequence<sizeof...(TArgs)>::type());
+                }
+            }
+            catch (const std::exception &e) {
+                sqlite3_result_error(context, e.what(), -1);
+            }
+        }
+        
+        static void xDestroy(void *p) {
+            delete static_cast<TypedAggregate *>(p);
+        }
+        
+    private:
+        //sqlite's allocations are 8 byte aligned
+        static_assert(alignof(State) <= 8, "usql: aggregate state needs a stricter alignment than sqlite3_aggregate_context gives");
+        
+        //sqlite hands out zeroed memory, so a new group is not constructed yet
+        struct Slot {
+            typename tr1::aligned_storage<sizeof(State), alignof(State)>::type storage;
+            bool constructed;
+        };
+        
+        static State *stateForContext(sqlite3_context *context) {
+            Slot *slot = static_cast<Slot *>(sqlite3_aggregate_context(context, sizeof(Slot)));
+            if (!slot) {
+                sqlite3_result_error_nomem(context);
+                return nullptr;
+            }
+            
+            if (!slot->constructed) {
+                new (&slot->storage) State(static_cast<TypedAggregate *>(sqlite3_user_data(context))->_prototype);
+                slot->constructed = true;
+            }
+            
+            return reinterpret_cast<State *>(&slot->storage);
+        }
+        
+        static void result(sqlite3_context *context, State &state) {
+            FunctionResult<typename tr1::decay<decltype(state.value())>::type>::set(context, state.value());
+        }
+        
+        template<size_t... I>
+        static void step(State &state, sqlite3_value **argv, Indexes<I...>) {
+            state.step(FunctionArgument<typename tr1::decay<TArgs>::type>::get(argv[I])...);
+        }
+        
+        template<size_t... I>
+        static void inverse(State &state, sqlite3_value **argv, Indexes<I...>) {
+            state.inverse(FunctionArgument<typename tr1::decay<TArgs>::type>::get(argv[I])...);
+        }
+        
+    private:
+        State _prototype;
+    };
+#endif
 }
 
 #endif /* Function_hpp */
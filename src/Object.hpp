@@ -50,6 +50,20 @@ namespace usql {
 		NoCopyable &operator=(const NoCopyable &other);
 #endif
     };
+    
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+    //IndexSequence<3>::type is Indexes<0, 1, 2>, expands tuples and argument arrays into parameter packs
+    template<size_t... I>
+    struct Indexes {};
+    
+    template<size_t N, size_t... I>
+    struct IndexSequence : IndexSequence<N - 1, N - 1, I...> {};
+    
+    template<size_t... I>
+    struct IndexSequence<0, I...> {
+        typedef Indexes<I...> type;
+    };
+#endif
 }
 
 #endif /* Object_hpp */
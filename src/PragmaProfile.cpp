@@ -0,0 +1,117 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "PragmaProfile.hpp"
+
+namespace usql {
+    PragmaProfile PragmaProfile::profile(OpenProfile profile) {
+        PragmaProfile p;
+        switch (profile) {
+            case _USQL_ENUM_VALUE(OpenProfile, ReadHeavy):
+                p.pageSize = 4096;
+                p.journalMode = "WAL";
+                p.synchronous = "NORMAL";
+                p.cacheSize = -64 * 1024;
+                p.mmapSize = 256 * 1024 * 1024;
+                p.tempStore = "MEMORY";
+                p.walAutocheckpoint = 1000;
+                break;
+                
+            case _USQL_ENUM_VALUE(OpenProfile, WriteHeavy):
+                p.pageSize = 4096;
+                p.journalMode = "WAL";
+                p.synchronous = "NORMAL";
+                p.cacheSize = -32 * 1024;
+                p.mmapSize = 0;
+                p.tempStore = "MEMORY";
+                p.walAutocheckpoint = 10000;
+                break;
+                
+            case _USQL_ENUM_VALUE(OpenProfile, Ephemeral):
+                p.pageSize = 4096;
+                p.journalMode = "MEMORY";
+                p.synchronous = "OFF";
+                p.cacheSize = -16 * 1024;
+                p.mmapSize = 0;
+                p.tempStore = "MEMORY";
+                break;
+                
+            case _USQL_ENUM_VALUE(OpenProfile, Durable):
+                p.journalMode = "WAL";
+                p.synchronous = "FULL";
+                p.walAutocheckpoint = 1000;
+                break;
+                
+            default:
+                break;
+        }
+        
+        return p;
+    }
+    
+    std::vector<std::string> PragmaProfile::commands() const {
+        std::vector<std::string> cmds;
+        std::stringstream buf;
+        if (pageSize != USQL_PRAGMA_UNSET) {
+            buf.str("");
+            buf<<"PRAGMA page_size="<<pageSize;
+            cmds.push_back(buf.str());
+        }
+        
+        if (!journalMode.empty()) {
+            cmds.push_back("PRAGMA journal_mode=" + journalMode);
+        }
+        
+        if (!synchronous.empty()) {
+            cmds.push_back("PRAGMA synchronous=" + synchronous);
+        }
+        
+        if (cacheSize != USQL_PRAGMA_UNSET) {
+            buf.str("");
+            buf<<"PRAGMA cache_size="<<cacheSize;
+            cmds.push_back(buf.str());
+        }
+        
+        if (mmapSize != USQL_PRAGMA_UNSET) {
+            buf.str("");
+            buf<<"PRAGMA mmap_size="<<mmapSize;
+            cmds.push_back(buf.str());
+        }
+        
+        if (!tempStore.empty()) {
+            cmds.push_back("PRAGMA temp_store=" + tempStore);
+        }
+        
+        if (walAutocheckpoint != USQL_PRAGMA_UNSET) {
+            buf.str("");
+            buf<<"PRAGMA wal_autocheckpoint="<<walAutocheckpoint;
+            cmds.push_back(buf.str());
+        }
+        
+        return cmds;
+    }
+}
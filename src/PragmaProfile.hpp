@@ -0,0 +1,64 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef PragmaProfile_hpp
+#define PragmaProfile_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+
+namespace usql {
+    //tuning pragmas applied right after a connection opens,
+    //empty strings and USQL_PRAGMA_UNSET leave the sqlite default
+    struct PragmaProfile
+    {
+        //applied before journal_mode, only takes effect on a new database
+        int pageSize;
+        std::string journalMode;
+        std::string synchronous;
+        //pages if positive, KiB if negative
+        int cacheSize;
+        int64_t mmapSize;
+        std::string tempStore;
+        //pages, 0 disables the automatic checkpoint
+        int walAutocheckpoint;
+        
+        PragmaProfile()
+        : pageSize(USQL_PRAGMA_UNSET)
+        , cacheSize(USQL_PRAGMA_UNSET)
+        , mmapSize(USQL_PRAGMA_UNSET)
+        , walAutocheckpoint(USQL_PRAGMA_UNSET) {}
+        
+        static PragmaProfile profile(OpenProfile profile);
+        
+        //the PRAGMA statements in the order they are applied
+        std::vector<std::string> commands() const;
+    };
+}
+
+#endif /* PragmaProfile_hpp */
@@ -38,6 +38,22 @@ namespace usql {
         return _stmt->reset();
     }
     
+    size_t Query::fetch(ColumnBatch &batch, size_t maxRows) {
+        batch.clear();
+        
+        sqlite3_stmt *stmt = _stmt->statement();
+        if (!stmt) {
+            return 0;
+        }
+        
+        batch.init(stmt);
+        while (batch.rowCount() < maxRows && next()) {
+            batch.append(stmt);
+        }
+        
+        return batch.rowCount();
+    }
+    
     int Query::columnCount() const {
         return _stmt->columnCount();
     }
@@ -96,8 +112,26 @@ namespace usql {
     }
     
     std::string Query::textForColumnIndex(int idx) {
-        const unsigned char *txt = cstrForColumnIndex(idx);
-        return std::string(txt ? (const char *)txt : USQL_ERROR_TEXT);
+        TextView txt = textViewForColumnIndex(idx);
+        return txt.isNull() ? std::string(USQL_ERROR_TEXT) : txt.str();
+    }
+    
+    TextView Query::textViewForName(const std::string &name) {
+        int i = columnIndexForName(name);
+        return textViewForColumnIndex(i);
+    }
+    
+    TextView Query::textViewForColumnIndex(int idx) {
+        return _stmt->viewForColumnIndex<char>(idx, _USQL_ENUM_VALUE(ColumnType, Text));
+    }
+    
+    BlobView Query::blobForName(const std::string &name) {
+        int i = columnIndexForName(name);
+        return blobForColumnIndex(i);
+    }
+    
+    BlobView Query::blobForColumnIndex(int idx) {
+        return _stmt->viewForColumnIndex<unsigned char>(idx, _USQL_ENUM_VALUE(ColumnType, Blob));
     }
     
     const unsigned char *Query::cstrForColumnIndex(int idx) {
@@ -28,6 +28,8 @@
 #define Query_hpp
 
 #include "Cursor.hpp"
+#include "DataView.hpp"
+#include "ColumnBatch.hpp"
 
 namespace usql {
     class Query : public Cursor
@@ -58,15 +60,172 @@ namespace usql {
         std::string textForName(const std::string &name);
         std::string textForColumnIndex(int idx);
         
+        //zero-copy accessors, the returned view is valid until the next next() or reset()
+        TextView textViewForName(const std::string &name);
+        TextView textViewForColumnIndex(int idx);
+        
+        BlobView blobForName(const std::string &name);
+        BlobView blobForColumnIndex(int idx);
+        
         double floatForName(const std::string &name);
         double floatForColumnIndex(int idx);
         
         std::time_t datetimeForName(const std::string &name);
         std::time_t datetimeForColumnIndex(int idx);
         
+        //steps up to maxRows rows into the batch, returns the number of rows fetched
+        //a batch shorter than maxRows is the last one
+        size_t fetch(ColumnBatch &batch, size_t maxRows);
+        
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+        //steps and decodes the row by column position, see RowDecoder
+        template<class... TArgs>
+        Result next(TArgs&... values);
+        
+        //decodes the current row into a tuple by column position
+        template<class... TArgs>
+        tr1::tuple<TArgs...> row();
+#endif
+        
     protected:
         const unsigned char *cstrForColumnIndex(int idx);
     };
+    
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+    //reads a single column of the current row as T
+    template<class T, class Enable = void>
+    struct ColumnValue;
+    
+    template<>
+    struct ColumnValue<bool> {
+        static bool get(Query &query, int idx) {
+            return query.booleanForColumnIndex(idx);
+        }
+    };
+    
+    template<class T>
+    struct ColumnValue<T, typename tr1::enable_if<tr1::is_integral<T>::value && (sizeof(T) <= sizeof(int))>::type> {
+        static T get(Query &query, int idx) {
+            return static_cast<T>(query.intForColumnIndex(idx));
+        }
+    };
+    
+    template<class T>
+    struct ColumnValue<T, typename tr1::enable_if<tr1::is_integral<T>::value && (sizeof(T) > sizeof(int))>::type> {
+        static T get(Query &query, int idx) {
+            return static_cast<T>(query.int64ForColumnIndex(idx));
+        }
+    };
+    
+    template<class T>
+    struct ColumnValue<T, typename tr1::enable_if<tr1::is_floating_point<T>::value>::type> {
+        static T get(Query &query, int idx) {
+            return static_cast<T>(query.floatForColumnIndex(idx));
+        }
+    };
+    
+    template<>
+    struct ColumnValue<std::string> {
+        static std::string get(Query &query, int idx) {
+            return query.textForColumnIndex(idx);
+        }
+    };
+    
+    template<>
+    struct ColumnValue<TextView> {
+        static TextView get(Query &query, int idx) {
+            return query.textViewForColumnIndex(idx);
+        }
+    };
+    
+    template<>
+    struct ColumnValue<BlobView> {
+        static BlobView get(Query &query, int idx) {
+            return query.blobForColumnIndex(idx);
+        }
+    };
+    
+    //walks the columns of the current row by position
+    class RowReader
+    {
+    public:
+        RowReader(Query &query, int first = 0) : _query(query), _index(first) {}
+        
+        template<class T>
+        RowReader &operator>>(T &value) {
+            value = ColumnValue<T>::get(_query, _index++);
+            return *this;
+        }
+        
+        int index() const {
+            return _index;
+        }
+        
+    private:
+        Query &_query;
+        int _index;
+    };
+    
+    //decodes one value from the row, specialize it to map a struct:
+    //template<> struct RowDecoder<Person> {
+    //    static void decode(RowReader &row, Person &p) { row>>p.name>>p.age; }
+    //};
+    template<class T>
+    struct RowDecoder {
+        static void decode(RowReader &row, T &value) {
+            row>>value;
+        }
+    };
+    
+    template<class... TArgs>
+    struct RowDecoder<tr1::tuple<TArgs...> > {
+        static void decode(RowReader &row, tr1::tuple<TArgs...> &value) {
+            decodeElement<0>(row, value);
+        }
+        
+    private:
+        template<size_t I>
+        static typename tr1::enable_if<(I < sizeof...(TArgs))>::type decodeElement(RowReader &row, tr1::tuple<TArgs...> &value) {
+            typedef typename tr1::tuple_element<I, tr1::tuple<TArgs...> >::type Element;
+            RowDecoder<Element>::decode(row, tr1::get<I>(value));
+            decodeElement<I + 1>(row, value);
+        }
+        
+        template<size_t I>
+        static typename tr1::enable_if<(I >= sizeof...(TArgs))>::type decodeElement(RowReader &, tr1::tuple<TArgs...> &) {
+        }
+    };
+    
+    namespace detail {
+        inline void decodeRow(RowReader &) {
+        }
+        
+        template<class T, class... TArgs>
+        void decodeRow(RowReader &row, T &value, TArgs&... values) {
+            RowDecoder<T>::decode(row, value);
+            decodeRow(row, values...);
+        }
+    }
+    
+    template<class... TArgs>
+    Result Query::next(TArgs&... values) {
+        Result ret = next();
+        if (ret) {
+            RowReader row(*this);
+            detail::decodeRow(row, values...);
+        }
+        
+        return ret;
+    }
+    
+    template<class... TArgs>
+    tr1::tuple<TArgs...> Query::row() {
+        tr1::tuple<TArgs...> values;
+        RowReader row(*this);
+        RowDecoder<tr1::tuple<TArgs...> >::decode(row, values);
+        return values;
+    }
+#endif
 }
 
 #endif /* Query_hpp */
@@ -60,28 +60,31 @@ namespace usql {
         }
         
         Result(bool res) {
-			int code = res ? SQLITE_OK : SQLITE_ERROR;
-			init(code, _USQL_SQLITE_ERRSTR(code), _USQL_ENUM_VALUE(ResultType, Normal));
+			init(res ? SQLITE_OK : SQLITE_ERROR, _USQL_ENUM_VALUE(ResultType, Normal));
 		}
         
         Result(int c, sqlite3 *db, ResultType type = _USQL_ENUM_VALUE(ResultType, Normal)) {
-			init(c, (db ? sqlite3_errmsg(db) : _USQL_SQLITE_ERRSTR(c)), type);
+			init(c, type);
+            //the handle may not outlive the result, failures keep a copy of the message
+            if (db && !isSuccess()) {
+                _description = sqlite3_errmsg(db);
+            }
 		}
         
-        Result(int c, _WeakDatabase db, ResultType type = _USQL_ENUM_VALUE(ResultType, Normal)) {
-			init(c, db.expired() ? _USQL_SQLITE_ERRSTR(c) :  db.lock()->errorDescription(c), type);
+        Result(int c, _WeakDatabase db, ResultType type = _USQL_ENUM_VALUE(ResultType, Normal)) : _db(db) {
+			init(c, type);
 		}
         
-        Result(int c, _Database db, ResultType type = _USQL_ENUM_VALUE(ResultType, Normal)) {
-			init(c, db->errorDescription(c), type);
+        Result(int c, _Database db, ResultType type = _USQL_ENUM_VALUE(ResultType, Normal)) : _db(db) {
+			init(c, type);
 		}
         
-        Result(int c, const std::string &msg, ResultType type = _USQL_ENUM_VALUE(ResultType, Normal)) {
-			init(c, msg, type);
+        Result(int c, const std::string &msg, ResultType type = _USQL_ENUM_VALUE(ResultType, Normal)) : _description(msg) {
+			init(c, type);
 		}
         
-        Result(const Result &other) {
-			init(other.code(), other.description(), other._type);
+        Result(const Result &other) : _description(other._description), _db(other._db) {
+			init(other._code, other._type);
 		}
 
         const Result & operator=(const Result &other) {
@@ -91,6 +94,7 @@ namespace usql {
             
             _code = other._code;
             _description = other._description;
+            _db = other._db;
             _type = other._type;
             return *this;
         }
@@ -99,8 +103,21 @@ namespace usql {
             return _code;
         }
         
+        //resolved on demand: failures read the last error message of the database,
+        //which is only accurate until the next call on that connection
         std::string description() const {
-            return _description;
+            if (!_description.empty()) {
+                return _description;
+            }
+            
+            if (!isSuccess()) {
+                _Database db = _db.lock();
+                if (db) {
+                    return db->errorDescription(_code);
+                }
+            }
+            
+            return _USQL_SQLITE_ERRSTR(_code);
         }
         
         bool isSuccess() const {
@@ -113,15 +130,16 @@ namespace usql {
         }
 
 	private:
-		void init(int c, const std::string &msg, ResultType type) {
+		void init(int c, ResultType type) {
 			_code = c;
-			_description = msg;
 			_type = type;
 		}
 
     public:
         int _code;
+        //explicit message, empty when resolved from _db or sqlite3_errstr
         std::string _description;
+        _WeakDatabase _db;
         ResultType _type;
     };
 }
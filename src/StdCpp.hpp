@@ -38,6 +38,12 @@
 #define _USQL_ENUM_VALUE(type, value) value
 #endif
 
+#if defined(_MSC_VER) && _MSC_VER < 1800 //Visual Studio 2013 (12.0)
+#define _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE 0
+#else
+#define _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE 1
+#endif
+
 
 #include <string>
 #include <sstream>
@@ -51,12 +57,14 @@
 #include <tr1/functional>
 #include <tr1/type_traits>
 #include <tr1/memory>
+#include <tr1/tuple>
 namespace tr1 = std::tr1;
 
 #else
 #include <functional>
 #include <type_traits>
 #include <memory>
+#include <tuple>
 namespace tr1 = std;
 
 #endif
@@ -66,8 +74,37 @@ namespace tr1 = std;
 #include <ctime>
 #include <cstdio>
 
+//views returned by Query are checked against next()/reset() when USQL_VIEW_GUARD is defined;
+//it changes the layout of DataView and Statement, so the library and every client must agree on it
+#if defined(USQL_VIEW_GUARD)
+#define _USQL_VIEW_GUARD_ENABLE 1
+#else
+#define _USQL_VIEW_GUARD_ENABLE 0
+#endif
+
 #include <sqlite3.h>
 #define _USQL_SQLITE_CREATE_FUNCTION_V2_ENABLE 1
 #define _USQL_SQLITE_ERRSTR(c) sqlite3_errstr((c)) 
 
+//sqlite3_create_window_function is available since sqlite 3.25.0
+#if SQLITE_VERSION_NUMBER >= 3025000
+#define _USQL_SQLITE_WINDOW_FUNCTION_ENABLE 1
+#else
+#define _USQL_SQLITE_WINDOW_FUNCTION_ENABLE 0
+#endif
+
+//sqlite3_bind_pointer is available since sqlite 3.20.0
+#if SQLITE_VERSION_NUMBER >= 3020000
+#define _USQL_SQLITE_BIND_POINTER_ENABLE 1
+#else
+#define _USQL_SQLITE_BIND_POINTER_ENABLE 0
+#endif
+
+//sqlite3_unlock_notify is only available when sqlite is built with SQLITE_ENABLE_UNLOCK_NOTIFY
+#if defined(SQLITE_ENABLE_UNLOCK_NOTIFY) || defined(USQL_ENABLE_UNLOCK_NOTIFY)
+#define _USQL_SQLITE_UNLOCK_NOTIFY_ENABLE 1
+#else
+#define _USQL_SQLITE_UNLOCK_NOTIFY_ENABLE 0
+#endif
+
 #endif /* StdCpp_hpp */
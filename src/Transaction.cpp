@@ -0,0 +1,68 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "Transaction.hpp"
+#include "Connection.hpp"
+
+namespace usql {
+    Transaction::Transaction(Connection &con, TransactionType type)
+    : _connection(con)
+    , _nested(con.inTransaction())
+    , _active(false)
+    , _begin(true) {
+        _begin = _nested ? con.savepoint() : con.beginTransaction(type);
+        _active = _begin.isSuccess();
+    }
+    
+    Transaction::~Transaction() {
+        if (_active) {
+            rollback();
+        }
+    }
+    
+    Result Transaction::commit() {
+        if (!_active) {
+            return Result::error();
+        }
+        
+        Result ret = _nested ? _connection.releaseSavepoint() : _connection.commit();
+        if (ret) {
+            _active = false;
+        }
+        
+        return ret;
+    }
+    
+    Result Transaction::rollback() {
+        if (!_active) {
+            return Result::error();
+        }
+        
+        _active = false;
+        return _nested ? _connection.rollbackToSavepoint() : _connection.rollback();
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef Transaction_hpp
+#define Transaction_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Result.hpp"
+
+namespace usql {
+    class Connection;
+    
+    //scope guard: begins a transaction, or a savepoint when one is already open,
+    //and rolls back on destruction unless commit() or rollback() was called,
+    //so helpers can nest without forcing an outer commit
+    class Transaction : public NoCopyable
+    {
+    public:
+        Transaction(Connection &con, TransactionType type = _USQL_ENUM_VALUE(TransactionType, Deferred));
+        virtual ~Transaction();
+        
+        bool isActive() const {
+            return _active;
+        }
+        
+        bool isNested() const {
+            return _nested;
+        }
+        
+        Result beginResult() const {
+            return _begin;
+        }
+        
+        //COMMIT, or RELEASE for a nested transaction
+        Result commit();
+        //ROLLBACK, or ROLLBACK TO and RELEASE for a nested transaction
+        Result rollback();
+        
+    private:
+        Connection &_connection;
+        bool _nested;
+        bool _active;
+        Result _begin;
+    };
+}
+
+#endif /* Transaction_hpp */
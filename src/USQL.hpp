@@ -32,10 +32,22 @@
 #include "Object.hpp"
 #include "Database.hpp"
 #include "Result.hpp"
+#include "DataView.hpp"
+#include "ColumnBatch.hpp"
 #include "Query.hpp"
 #include "Cursor.hpp"
+#include "BlobStream.hpp"
 #include "Function.hpp"
+#include "VirtualTable.hpp"
+#include "ContainerTable.hpp"
+#include "ArrayTable.hpp"
+#include "PragmaProfile.hpp"
 #include "Connection.hpp"
+#include "Transaction.hpp"
+#include "BulkInserter.hpp"
+#include "ConnectionPool.hpp"
+#include "WriteQueue.hpp"
+#include "CheckpointScheduler.hpp"
 
 #include "Command.hpp"
 #include "ExprCommand.hpp"
@@ -36,6 +36,36 @@
 
 #define USQL_INVALID_COLUMN_INDEX -1
 #define USQL_INVALID_PARAMETER_INDEX 0
+//leaves a pragma at its default, negative cache sizes are valid values
+#define USQL_PRAGMA_UNSET (-2147483647 - 1)
+
+#define USQL_DEFAULT_STATEMENT_CACHE_CAPACITY 32
+#define USQL_DEFAULT_BULK_INSERT_BATCH_ROWS 10000
+//SQLITE_MAX_VARIABLE_NUMBER before sqlite 3.32.0
+#define USQL_DEFAULT_MAX_VARIABLE_NUMBER 999
+#define USQL_DEFAULT_POOL_READERS 4
+//milliseconds
+#define USQL_DEFAULT_POOL_TIMEOUT 5000
+#define USQL_DEFAULT_WRITE_QUEUE_BATCH_SIZE 1000
+//microseconds
+#define USQL_DEFAULT_BUSY_INITIAL_DELAY 100
+#define USQL_DEFAULT_BUSY_MAX_DELAY 50000
+//wal pages
+#define USQL_DEFAULT_CHECKPOINT_FRAMES 1000
+//milliseconds
+#define USQL_DEFAULT_CHECKPOINT_IDLE_TIME 500
+//pages
+#define USQL_DEFAULT_BACKUP_PAGES_PER_STEP 100
+//milliseconds
+#define USQL_DEFAULT_BACKUP_STEP_INTERVAL 0
+//milliseconds
+#define USQL_DEFAULT_BACKUP_BUSY_TIMEOUT 5000
+//bytes
+#define USQL_DEFAULT_BLOB_CHUNK_SIZE 65536
+//milliseconds
+#define USQL_DEFAULT_SLOW_QUERY_THRESHOLD 100
+#define USQL_DEFAULT_SLOW_QUERY_LOG_SIZE 100
+#define USQL_DEFAULT_PROFILER_STATEMENTS 1000
 
 namespace usql {
     _USQL_ENUM_CLASS_DEF(Encoding) {
@@ -77,6 +107,19 @@ namespace usql {
         Copy,
         Static
     };
+    
+    _USQL_ENUM_CLASS_DEF(OpenProfile) {
+        //sqlite defaults
+        DefaultProfile,
+        //WAL, synchronous=NORMAL, large page cache and mmap
+        ReadHeavy,
+        //WAL, synchronous=NORMAL, rare automatic checkpoints
+        WriteHeavy,
+        //in-memory journal and temp store, synchronous=OFF, not crash safe
+        Ephemeral,
+        //WAL, synchronous=FULL
+        Durable
+    };
 }
 
 #endif /* USQLDefs_hpp */
@@ -0,0 +1,182 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "VirtualTable.hpp"
+#include "Utils.hpp"
+
+namespace usql {
+    namespace {
+        struct TableHandle : public sqlite3_vtab
+        {
+            _VirtualTable table;
+            
+            TableHandle(const _VirtualTable &t) : table(t) {
+                pModule = nullptr;
+                nRef = 0;
+                zErrMsg = nullptr;
+            }
+        };
+        
+        struct CursorHandle : public sqlite3_vtab_cursor
+        {
+            VirtualTableCursor *cursor;
+            
+            CursorHandle(VirtualTableCursor *c) : cursor(c) {
+                pVtab = nullptr;
+            }
+            
+            ~CursorHandle() {
+                delete cursor;
+            }
+        };
+        
+        int setError(sqlite3_vtab *vtab, const char *message) {
+            sqlite3_free(vtab->zErrMsg);
+            vtab->zErrMsg = sqlite3_mprintf("%s", message);
+            return SQLITE_ERROR;
+        }
+        
+        VirtualTableCursor *cursorOf(sqlite3_vtab_cursor *cur) {
+            return static_cast<CursorHandle *>(cur)->cursor;
+        }
+        
+        int xConnect(sqlite3 *db, void *aux, int, const char *const *, sqlite3_vtab **ppVtab, char **pzErr) {
+            const _VirtualTable &table = *static_cast<_VirtualTable *>(aux);
+            try {
+                int code = sqlite3_declare_vtab(db, table->declaration().c_str());
+                if (!_USQL_OK(code)) {
+                    return code;
+                }
+                
+                *ppVtab = new TableHandle(table);
+                return SQLITE_OK;
+            }
+            catch (const std::exception &e) {
+                *pzErr = sqlite3_mprintf("%s", e.what());
+                return SQLITE_ERROR;
+            }
+        }
+        
+        int xDisconnect(sqlite3_vtab *vtab) {
+            delete static_cast<TableHandle *>(vtab);
+            return SQLITE_OK;
+        }
+        
+        int xBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+            try {
+                return static_cast<TableHandle *>(vtab)->table->bestIndex(info);
+            }
+            catch (const std::exception &e) {
+                return setError(vtab, e.what());
+            }
+        }
+        
+        int xOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor) {
+            try {
+                VirtualTableCursor *cursor = static_cast<TableHandle *>(vtab)->table->openCursor();
+                if (!cursor) {
+                    return SQLITE_NOMEM;
+                }
+                
+                *ppCursor = new CursorHandle(cursor);
+                return SQLITE_OK;
+            }
+            catch (const std::exception &e) {
+                return setError(vtab, e.what());
+            }
+        }
+        
+        int xClose(sqlite3_vtab_cursor *cur) {
+            delete static_cast<CursorHandle *>(cur);
+            return SQLITE_OK;
+        }
+        
+        int xFilter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr, int argc, sqlite3_value **argv) {
+            try {
+                return cursorOf(cur)->filter(idxNum, idxStr, FunctionArguments(argv, argc));
+            }
+            catch (const std::exception &e) {
+                return setError(cur->pVtab, e.what());
+            }
+        }
+        
+        int xNext(sqlite3_vtab_cursor *cur) {
+            try {
+                return cursorOf(cur)->next();
+            }
+            catch (const std::exception &e) {
+                return setError(cur->pVtab, e.what());
+            }
+        }
+        
+        int xEof(sqlite3_vtab_cursor *cur) {
+            return cursorOf(cur)->eof() ? 1 : 0;
+        }
+        
+        int xColumn(sqlite3_vtab_cursor *cur, sqlite3_context *context, int column) {
+            try {
+                return cursorOf(cur)->column(context, column);
+            }
+            catch (const std::exception &e) {
+                sqlite3_result_error(context, e.what(), -1);
+                return SQLITE_ERROR;
+            }
+        }
+        
+        int xRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid) {
+            *rowid = cursorOf(cur)->rowid();
+            return SQLITE_OK;
+        }
+        
+        //xCreate stays null, that makes the module eponymous only
+        sqlite3_module makeModule() {
+            sqlite3_module module;
+            memset(&module, 0, sizeof(module));
+            module.xConnect = xConnect;
+            module.xBestIndex = xBestIndex;
+            module.xDisconnect = xDisconnect;
+            module.xDestroy = xDisconnect;
+            module.xOpen = xOpen;
+            module.xClose = xClose;
+            module.xFilter = xFilter;
+            module.xNext = xNext;
+            module.xEof = xEof;
+            module.xColumn = xColumn;
+            module.xRowid = xRowid;
+            return module;
+        }
+    }
+    
+    const sqlite3_module *VirtualTable::module() {
+        static const sqlite3_module module = makeModule();
+        return &module;
+    }
+    
+    void VirtualTable::xDestroy(void *p) {
+        delete static_cast<_VirtualTable *>(p);
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef VirtualTable_hpp
+#define VirtualTable_hpp
+
+#include "StdCpp.hpp"
+#include "Object.hpp"
+#include "Function.hpp"
+
+namespace usql {
+    //one scan of a virtual table, sqlite opens a cursor per statement and loop
+    class VirtualTableCursor : public NoCopyable
+    {
+    public:
+        virtual ~VirtualTableCursor() {}
+        
+        //starts a scan with the plan VirtualTable::bestIndex chose, the methods return sqlite codes
+        virtual int filter(int idxNum, const char *idxStr, const FunctionArguments &argv) = 0;
+        virtual int next() = 0;
+        virtual bool eof() const = 0;
+        virtual int column(sqlite3_context *context, int column) = 0;
+        virtual sqlite3_int64 rowid() const = 0;
+    };
+    
+    //a read-only module served by Connection::registerTable; the table is eponymous, it is queried
+    //by the registered name without CREATE VIRTUAL TABLE. exceptions become the statement's error
+    class VirtualTable : public NoCopyable
+    {
+    public:
+        virtual ~VirtualTable() {}
+        
+        //e.g. "create table x(id integer, name text)", sqlite ignores the table name
+        virtual std::string declaration() const = 0;
+        virtual int bestIndex(sqlite3_index_info *info) = 0;
+        virtual VirtualTableCursor *openCursor() = 0;
+        
+        //the module passed to sqlite3_create_module_v2 with a new _VirtualTable as client data
+        static const sqlite3_module *module();
+        static void xDestroy(void *p);
+    };
+    
+    typedef tr1::shared_ptr<VirtualTable> _VirtualTable;
+}
+
+#endif /* VirtualTable_hpp */
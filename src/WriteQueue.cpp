@@ -0,0 +1,267 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "WriteQueue.hpp"
+#include "Connection.hpp"
+#include <exception>
+
+#define USQL_WRITE_QUEUE_SAVEPOINT "usql_write_queue"
+
+namespace usql {
+    WriteQueue::WriteQueue(Connection &con)
+    : _connection(con)
+    , _maxBatchSize(USQL_DEFAULT_WRITE_QUEUE_BATCH_SIZE)
+    , _maxLatency(0)
+    , _head(&_stub)
+    , _tail(&_stub)
+    , _running(false)
+    , _stopping(false)
+    , _producers(0)
+    , _waiting(false)
+    , _writeCount(0)
+    , _commitCount(0) {
+    }
+    
+    WriteQueue::~WriteQueue() {
+        stop();
+    }
+    
+    Result WriteQueue::start() {
+        if (_running) {
+            return Result::success();
+        }
+        
+        if (!_connection.isOpenning()) {
+            return false;
+        }
+        
+        _stopping = false;
+        _running = true;
+        _thread = std::thread(&WriteQueue::run, this);
+        return Result::success();
+    }
+    
+    void WriteQueue::stop() {
+        if (!_running) {
+            return;
+        }
+        
+        //a producer either sees _stopping or is counted here and finishes its push first
+        _stopping = true;
+        while (_producers.load() > 0) {
+            std::this_thread::yield();
+        }
+        
+        wakeup();
+        _thread.join();
+        _running = false;
+        
+        //the thread runs everything accepted, this only catches what it could not
+        while (!drained()) {
+            Request *request = pop();
+            if (!request) {
+                std::this_thread::yield();
+                continue;
+            }
+            
+            request->promise.set_value(Result(SQLITE_MISUSE, _USQL_SQLITE_ERRSTR(SQLITE_MISUSE)));
+            delete request;
+        }
+    }
+    
+    std::future<Result> WriteQueue::enqueue(const Task &task) {
+        Request *request = new Request(task);
+        std::future<Result> future = request->promise.get_future();
+        ++_producers;
+        if (!_running || _stopping || !task) {
+            --_producers;
+            request->promise.set_value(Result(SQLITE_MISUSE, _USQL_SQLITE_ERRSTR(SQLITE_MISUSE)));
+            delete request;
+            return future;
+        }
+        
+        push(request);
+        --_producers;
+        if (_waiting) {
+            wakeup();
+        }
+        
+        return future;
+    }
+    
+    std::future<Result> WriteQueue::enqueue(const std::string &cmd) {
+        return enqueue([cmd](Connection &con)->Result {
+            return con.exec(cmd);
+        });
+    }
+    
+    void WriteQueue::push(Node *node) {
+        node->next.store(nullptr);
+        Node *prev = _head.exchange(node);
+        prev->next.store(node);
+    }
+    
+    WriteQueue::Request *WriteQueue::pop() {
+        Node *tail = _tail;
+        Node *next = tail->next.load();
+        if (tail == &_stub) {
+            if (!next) {
+                return nullptr;
+            }
+            
+            _tail = next;
+            tail = next;
+            next = next->next.load();
+        }
+        
+        if (next) {
+            _tail = next;
+            return static_cast<Request *>(tail);
+        }
+        
+        //a producer is between exchange and link
+        if (tail != _head.load()) {
+            return nullptr;
+        }
+        
+        push(&_stub);
+        next = tail->next.load();
+        if (next) {
+            _tail = next;
+            return static_cast<Request *>(tail);
+        }
+        
+        return nullptr;
+    }
+    
+    bool WriteQueue::drained() const {
+        //a request at the tail is still queued, only the stub marks an empty queue
+        return _tail == &_stub && _head.load() == &_stub && _stub.next.load() == nullptr;
+    }
+    
+    void WriteQueue::wait(Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _waiting = true;
+        //re-check after publishing the flag, a producer either sees it or its request is visible
+        if (drained() && !_stopping) {
+            _available.wait_until(lock, deadline);
+        }
+        _waiting = false;
+    }
+    
+    void WriteQueue::wakeup() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _available.notify_one();
+    }
+    
+    void WriteQueue::run() {
+        while (true) {
+            Request *request = pop();
+            if (request) {
+                runBatch(request);
+                continue;
+            }
+            
+            //pops can miss a push half way through, only leave once every producer is done
+            if (_stopping && _producers.load() == 0 && drained()) {
+                break;
+            }
+            
+            wait(Clock::now() + std::chrono::milliseconds(100));
+        }
+    }
+    
+    void WriteQueue::runBatch(Request *first) {
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(_maxLatency.load());
+        size_t limit = _maxBatchSize;
+        
+        Result ret = _connection.beginTransaction(_USQL_ENUM_VALUE(TransactionType, Immediate));
+        if (!ret) {
+            first->promise.set_value(ret);
+            delete first;
+            return;
+        }
+        
+        _batch.clear();
+        execute(first);
+        while (_batch.size() < limit) {
+            Request *request = pop();
+            if (request) {
+                execute(request);
+                continue;
+            }
+            
+            if (_stopping || Clock::now() >= deadline) {
+                break;
+            }
+            
+            wait(deadline);
+        }
+        
+        ret = _connection.commit();
+        if (!ret) {
+            _connection.rollback();
+        }
+        else {
+            ++_commitCount;
+            _writeCount += _batch.size();
+        }
+        
+        for (auto iter = _batch.begin(); iter != _batch.end(); ++iter) {
+            Request *request = *iter;
+            request->promise.set_value(request->result ? ret : request->result);
+            delete request;
+        }
+        _batch.clear();
+    }
+    
+    void WriteQueue::execute(Request *request) {
+        _batch.push_back(request);
+        
+        request->result = _connection.exec("SAVEPOINT " USQL_WRITE_QUEUE_SAVEPOINT);
+        if (!request->result) {
+            return;
+        }
+        
+        //a throwing task must not take the thread down with the savepoint still open
+        try {
+            request->result = request->task(_connection);
+        }
+        catch (const std::exception &e) {
+            request->result = Result(SQLITE_ERROR, e.what());
+        }
+        catch (...) {
+            request->result = Result(SQLITE_ERROR, _USQL_SQLITE_ERRSTR(SQLITE_ERROR));
+        }
+        
+        if (!request->result) {
+            _connection.exec("ROLLBACK TO " USQL_WRITE_QUEUE_SAVEPOINT);
+        }
+        
+        _connection.exec("RELEASE " USQL_WRITE_QUEUE_SAVEPOINT);
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#ifndef WriteQueue_hpp
+#define WriteQueue_hpp
+
+#include "StdCpp.hpp"
+#include "USQLDefs.hpp"
+#include "Object.hpp"
+#include "Result.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace usql {
+    class Connection;
+    
+    //runs writes from any thread on one background thread, everything queued is coalesced into
+    //one IMMEDIATE transaction and committed once; each write runs in its own savepoint,
+    //so a failing write is rolled back alone and its future gets its own result
+    class WriteQueue : public NoCopyable
+    {
+    public:
+        typedef tr1::function<Result(Connection &)> Task;
+        
+        //the connection belongs to the background thread between start() and stop()
+        WriteQueue(Connection &con);
+        
+        //drains the queued writes
+        virtual ~WriteQueue();
+        
+        //upper bound of writes per transaction
+        void setMaxBatchSize(size_t size) {
+            _maxBatchSize = std::max<size_t>(1, size);
+        }
+        size_t maxBatchSize() const {
+            return _maxBatchSize;
+        }
+        
+        //milliseconds an open batch waits for more writes when the queue runs empty,
+        //0 commits as soon as the queue drains
+        void setMaxLatency(int milliseconds) {
+            _maxLatency = std::max(0, milliseconds);
+        }
+        int maxLatency() const {
+            return _maxLatency;
+        }
+        
+        Result start();
+        //commits the queued writes and joins the background thread
+        void stop();
+        
+        bool isRunning() const {
+            return _running;
+        }
+        
+        //the future is ready once the batch holding the write has committed or failed
+        std::future<Result> enqueue(const Task &task);
+        std::future<Result> enqueue(const std::string &cmd);
+        
+        uint64_t writeCount() const {
+            return _writeCount;
+        }
+        
+        uint64_t commitCount() const {
+            return _commitCount;
+        }
+        
+        double averageBatchSize() const {
+            uint64_t commits = _commitCount;
+            return commits ? static_cast<double>(_writeCount) / commits : 0;
+        }
+        
+    private:
+        struct Node
+        {
+            std::atomic<Node *> next;
+            
+            Node() : next(nullptr) {}
+        };
+        
+        struct Request : public Node
+        {
+            Task task;
+            std::promise<Result> promise;
+            Result result;
+            
+            Request(const Task &t) : task(t), result(true) {}
+        };
+        
+        typedef std::chrono::steady_clock Clock;
+        
+        //intrusive multi-producer single-consumer queue, push never blocks
+        void push(Node *node);
+        Request *pop();
+        //nothing queued and no push half way through
+        bool drained() const;
+        
+        void run();
+        void runBatch(Request *first);
+        void execute(Request *request);
+        void wait(Clock::time_point deadline);
+        void wakeup();
+        
+    private:
+        Connection &_connection;
+        std::atomic<size_t> _maxBatchSize;
+        std::atomic<int> _maxLatency;
+        
+        std::atomic<Node *> _head;
+        Node *_tail;
+        Node _stub;
+        
+        std::thread _thread;
+        std::atomic<bool> _running;
+        std::atomic<bool> _stopping;
+        //producers between the running check and the end of their push, stop() waits for them
+        std::atomic<int> _producers;
+        std::atomic<bool> _waiting;
+        std::mutex _mutex;
+        std::condition_variable _available;
+        
+        std::vector<Request *> _batch;
+        std::atomic<uint64_t> _writeCount;
+        std::atomic<uint64_t> _commitCount;
+    };
+}
+
+#endif /* WriteQueue_hpp */
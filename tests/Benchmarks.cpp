@@ -0,0 +1,1104 @@
+/**
+ Copyright (c) 2015, 2coding
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "Tests.hpp"
+#include "USQL.hpp"
+#include <sstream>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <deque>
+
+using namespace usql;
+
+//the replacement allocator is global to the test binary, it only counts while an
+//AllocationCounter is alive so the rest of the tests just pass through to malloc
+static std::atomic<uint64_t> _allocations(0);
+static std::atomic<int> _allocationCounters(0);
+
+//inlined into a caller, gcc reports the free() below as a mismatch for operator new
+#if defined(__GNUC__)
+#define BENCH_ALLOCATOR __attribute__((noinline))
+#else
+#define BENCH_ALLOCATOR
+#endif
+
+static inline void countAllocation() {
+    if (_allocationCounters.load(std::memory_order_relaxed) > 0) {
+        _allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+BENCH_ALLOCATOR void *operator new(size_t size) {
+    countAllocation();
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    
+    return p;
+}
+
+//std::stable_sort takes its buffer through the nothrow form
+BENCH_ALLOCATOR void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    countAllocation();
+    return std::malloc(size ? size : 1);
+}
+
+BENCH_ALLOCATOR void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+BENCH_ALLOCATOR void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+BENCH_ALLOCATOR void operator delete(void *p, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+
+//heap allocations made by any thread between construction and count()
+class AllocationCounter
+{
+public:
+    AllocationCounter() {
+        ++_allocationCounters;
+        _begin = _allocations;
+    }
+    
+    ~AllocationCounter() {
+        --_allocationCounters;
+    }
+    
+    uint64_t count() const {
+        return _allocations - _begin;
+    }
+    
+private:
+    uint64_t _begin;
+};
+
+#ifdef _MSC_VER
+static const char *_benchmark_db = "usqlite_benchmark.db";
+#else
+static const char *_benchmark_db = "/tmp/usqlite_benchmark.db";
+#endif
+
+#pragma mark - benchmarks
+class USQLBenchmarks : public testing::Test
+{
+public:
+    USQLBenchmarks() : _connection(_benchmark_db) {}
+    
+protected:
+    virtual void SetUp() {
+        std::remove(_benchmark_db);
+        _connection.open();
+    }
+    
+    virtual void TearDown() {
+        _connection.close();
+        std::remove(_benchmark_db);
+    }
+    
+    //creates bench_wide_table (c0 int, c1 text, c2 real, c3 int, ...) with rows rows
+    bool createWideTable(int columns, int rows) {
+        std::stringstream create;
+        std::stringstream insert;
+        std::stringstream values;
+        create<<"create table bench_wide_table (";
+        insert<<"insert into bench_wide_table (";
+        for (int i = 0; i < columns; ++i) {
+            if (i) {
+                create<<", ";
+                insert<<", ";
+                values<<", ";
+            }
+            
+            create<<columnName(i)<<(i % 3 == 0 ? " int" : (i % 3 == 1 ? " text" : " real"));
+            insert<<columnName(i);
+            values<<"?";
+        }
+        create<<")";
+        insert<<") values ("<<values.str()<<")";
+        
+        if (!_connection.exec(create.str())) {
+            return false;
+        }
+        
+        return _connection.transaction(_USQL_ENUM_VALUE(TransactionType, Immediate), [&](Connection &con)->bool{
+            Cursor cursor(insert.str(), con);
+            for (int r = 0; r < rows; ++r) {
+                for (int i = 0; i < columns; ++i) {
+                    if (i % 3 == 0) {
+                        cursor.bind(i + 1, r);
+                    }
+                    else if (i % 3 == 1) {
+                        cursor.bind(i + 1, std::string("text value"));
+                    }
+                    else {
+                        cursor.bind(i + 1, r * 0.5);
+                    }
+                }
+                
+                if (!cursor.exec()) {
+                    return false;
+                }
+            }
+            
+            return true;
+        });
+    }
+    
+    static std::string columnName(int i) {
+        std::stringstream ss;
+        ss<<"c"<<i;
+        return ss.str();
+    }
+    
+    static double seconds(std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    
+    static void report(const std::string &name, double count, const std::string &unit, double secs) {
+        std::cout<<"[ BENCHMARK ] "<<name<<": "<<static_cast<int64_t>(count / (secs > 0 ? secs : 1e-9))<<" "<<unit<<"/sec"<<std::endl;
+    }
+    
+protected:
+    Connection _connection;
+};
+
+TEST_F(USQLBenchmarks, wide_table_scan_by_name)
+{
+    const int columns = 32;
+    const int rows = 20000;
+    ASSERT_TRUE(createWideTable(columns, rows));
+    
+    std::vector<std::string> names;
+    for (int i = 0; i < columns; ++i) {
+        names.push_back(columnName(i));
+    }
+    
+    auto begin = std::chrono::steady_clock::now();
+    Query query("select * from bench_wide_table", _connection);
+    int count = 0;
+    int64_t sum = 0;
+    while (query.next()) {
+        for (int i = 0; i < columns; i += 3) {
+            sum += query.intForName(names[i]);
+        }
+        ++count;
+    }
+    report("wide table scan by name", count, "rows", seconds(begin));
+    
+    EXPECT_EQ(rows, count);
+    EXPECT_EQ(static_cast<int64_t>(rows - 1) * rows / 2 * ((columns + 2) / 3), sum);
+}
+
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLBenchmarks, wide_table_scan_typed)
+{
+    const int columns = 32;
+    const int rows = 20000;
+    ASSERT_TRUE(createWideTable(columns, rows));
+    
+    auto begin = std::chrono::steady_clock::now();
+    Query query("select c0, c1, c2, c3, c4, c5 from bench_wide_table", _connection);
+    int count = 0;
+    int64_t sum = 0;
+    int c0 = 0, c3 = 0;
+    TextView c1, c4;
+    double c2 = 0, c5 = 0;
+    while (query.next(c0, c1, c2, c3, c4, c5)) {
+        sum += c0 + c3;
+        ++count;
+    }
+    report("wide table scan typed", count, "rows", seconds(begin));
+    
+    EXPECT_EQ(rows, count);
+    EXPECT_EQ(static_cast<int64_t>(rows - 1) * rows, sum);
+}
+#endif
+
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLBenchmarks, bulk_insert)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_insert_table (a int, b real, c text)"));
+    
+    const int rows = 200000;
+    std::vector<std::string> columns;
+    columns.push_back("a");
+    columns.push_back("b");
+    columns.push_back("c");
+    
+    BulkInserter inserter(_connection, "bench_insert_table", columns);
+    const std::string text = "bulk insert text value";
+    for (int i = 0; i < rows; ++i) {
+        ASSERT_TRUE(inserter.insert(i, i * 0.5, text));
+    }
+    ASSERT_TRUE(inserter.flush());
+    std::cout<<"[ BENCHMARK ] bulk insert: "<<static_cast<int64_t>(inserter.rowsPerSecond())<<" rows/sec"<<std::endl;
+    
+    EXPECT_EQ(rows, inserter.rowCount());
+}
+#endif
+
+TEST_F(USQLBenchmarks, pooled_reads)
+{
+    ASSERT_TRUE(createWideTable(8, 2000));
+    _connection.close();
+    
+    ConnectionPool pool(_benchmark_db, 4);
+    ASSERT_TRUE(pool.open());
+    
+    const int queries = 400;
+    for (int threads = 1; threads <= 4; threads *= 2) {
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(std::thread([&pool, queries, threads]() {
+                for (int n = 0; n < queries / threads; ++n) {
+                    auto reader = pool.reader();
+                    Query query("select sum(c0), count(c1) from bench_wide_table", *reader);
+                    query.next();
+                }
+            }));
+        }
+        for (auto iter = workers.begin(); iter != workers.end(); ++iter) {
+            iter->join();
+        }
+        
+        std::stringstream name;
+        name<<"pooled reads, "<<threads<<" threads";
+        report(name.str(), queries, "queries", seconds(begin));
+    }
+    
+    auto stats = pool.stats();
+    std::cout<<"[ BENCHMARK ] pool waits: "<<stats.waits<<", total wait: "<<stats.totalWaitMilliseconds<<" ms, reader utilisation: "<<stats.readerUtilisation<<std::endl;
+    EXPECT_EQ(0, stats.timeouts);
+    EXPECT_TRUE(pool.close());
+}
+
+TEST_F(USQLBenchmarks, write_queue_group_commit)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_queue_table (a int, b text)"));
+    
+    const int writes = 400;
+    const int threads = 4;
+    
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < writes; ++i) {
+        Cursor cursor("insert into bench_queue_table (a, b) values (?, 'single')", _connection);
+        cursor.bind(1, i);
+        ASSERT_TRUE(cursor.exec());
+    }
+    report("write per commit", writes, "writes", seconds(begin));
+    
+    WriteQueue queue(_connection);
+    ASSERT_TRUE(queue.start());
+    begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&queue, writes, threads]() {
+            std::vector<std::future<Result>> futures;
+            for (int i = 0; i < writes / threads; ++i) {
+                futures.push_back(queue.enqueue([i](Connection &con)->Result {
+                    Cursor cursor("insert into bench_queue_table (a, b) values (?, 'queued')", con);
+                    cursor.bind(1, i);
+                    return cursor.exec();
+                }));
+            }
+            
+            for (auto iter = futures.begin(); iter != futures.end(); ++iter) {
+                iter->get();
+            }
+        }));
+    }
+    for (auto iter = workers.begin(); iter != workers.end(); ++iter) {
+        iter->join();
+    }
+    report("write queue group commit", writes, "writes", seconds(begin));
+    std::cout<<"[ BENCHMARK ] write queue average batch: "<<queue.averageBatchSize()<<" writes/commit"<<std::endl;
+    queue.stop();
+    
+    EXPECT_EQ(writes, queue.writeCount());
+}
+
+TEST_F(USQLBenchmarks, bind_step_allocations)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_alloc_table (a int, b real)"));
+    ASSERT_TRUE(_connection.beginTransaction(_USQL_ENUM_VALUE(TransactionType, Immediate)));
+    
+    const int rows = 100000;
+    Cursor cursor("insert into bench_alloc_table (a, b) values (?, ?)", _connection);
+    ASSERT_TRUE(cursor.exec());
+    
+    AllocationCounter counter;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < rows; ++i) {
+        Result ret = cursor.bind(1, i);
+        ret = cursor.bind(2, i * 0.5);
+        ret = cursor.exec();
+        if (!ret) {
+            break;
+        }
+    }
+    double secs = seconds(begin);
+    uint64_t allocations = counter.count();
+    report("bind and step", rows, "rows", secs);
+    std::cout<<"[ BENCHMARK ] bind and step allocations: "<<allocations<<std::endl;
+    ASSERT_TRUE(_connection.commit());
+    
+    EXPECT_EQ(0, allocations);
+    
+    Query query("select a, b from bench_alloc_table", _connection);
+    EXPECT_TRUE(query.next());
+    AllocationCounter stepCounter;
+    int count = 0;
+    while (query.next()) {
+        ++count;
+    }
+    allocations = stepCounter.count();
+    std::cout<<"[ BENCHMARK ] query step allocations: "<<allocations<<std::endl;
+    
+    EXPECT_EQ(rows, count);
+    EXPECT_EQ(0, allocations);
+}
+
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLBenchmarks, point_lookup)
+{
+    const int rows = 20000;
+    ASSERT_TRUE(_connection.exec("create table bench_lookup_table (id integer primary key, a int, b text, c real)"));
+    BulkInserter inserter(_connection, "bench_lookup_table", std::vector<std::string>(1, "a"));
+    for (int i = 0; i < rows; ++i) {
+        ASSERT_TRUE(inserter.insert(i));
+    }
+    ASSERT_TRUE(inserter.flush());
+    
+    const int lookups = 200000;
+    Query query("select a from bench_lookup_table where id >= ? and id < ? and a >= ? and c is ?", _connection);
+    int64_t sum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        int id = i % rows + 1;
+        query.bindAll(id, id + 1, 0, nullptr);
+        if (query.next()) {
+            sum += query.intForColumnIndex(0);
+        }
+    }
+    report("point lookup, 4 parameters", lookups, "lookups", seconds(begin));
+    
+    EXPECT_EQ(static_cast<int64_t>(rows - 1) * rows / 2 * (lookups / rows), sum);
+}
+#endif
+
+TEST_F(USQLBenchmarks, named_binding)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_named_table (alpha int, bravo real, charlie int, delta real)"));
+    ASSERT_TRUE(_connection.beginTransaction(_USQL_ENUM_VALUE(TransactionType, Immediate)));
+    
+    const int rows = 100000;
+    const std::string cmd = "insert into bench_named_table values (:alpha, :bravo, :charlie, :delta)";
+    Cursor cursor(cmd, _connection);
+    const std::string alpha = ":alpha", bravo = ":bravo", charlie = ":charlie", delta = ":delta";
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < rows; ++i) {
+        cursor.bind(alpha, i);
+        cursor.bind(bravo, i * 0.5);
+        cursor.bind(charlie, i);
+        cursor.bind(delta, i * 0.5);
+        cursor.exec();
+    }
+    report("bind by name", rows, "rows", seconds(begin));
+    
+    Parameter a = cursor.parameter(alpha), b = cursor.parameter(bravo), c = cursor.parameter(charlie), d = cursor.parameter(delta);
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < rows; ++i) {
+        cursor.bind(a, i);
+        cursor.bind(b, i * 0.5);
+        cursor.bind(c, i);
+        cursor.bind(d, i * 0.5);
+        cursor.exec();
+    }
+    report("bind by parameter handle", rows, "rows", seconds(begin));
+    
+    ASSERT_TRUE(_connection.commit());
+    Query query("select count(*) from bench_named_table", _connection);
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(rows * 2, query.intForColumnIndex(0));
+}
+
+TEST_F(USQLBenchmarks, statement_churn)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_churn_table (a int)"));
+    _connection.setStatementCacheCapacity(0);
+    auto db = _connection.database().lock();
+    
+    //keep many statements registered while others are prepared and finalized
+    const int live = 10000;
+    std::vector<Cursor *> cursors;
+    for (int i = 0; i < live; ++i) {
+        std::stringstream cmd;
+        cmd<<"select a + "<<i<<" from bench_churn_table";
+        cursors.push_back(new Cursor(cmd.str(), _connection));
+    }
+    EXPECT_EQ(live, db->statementCount());
+    
+    const int churn = 100000;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < churn; ++i) {
+        Cursor cursor("select a from bench_churn_table", _connection);
+    }
+    report("statement prepare and finalize", churn, "statements", seconds(begin));
+    EXPECT_EQ(live, db->statementCount());
+    
+    begin = std::chrono::steady_clock::now();
+    for (auto iter = cursors.begin(); iter != cursors.end(); ++iter) {
+        delete *iter;
+    }
+    report("statement finalize, oldest first", live, "statements", seconds(begin));
+    EXPECT_EQ(0, db->statementCount());
+}
+
+TEST_F(USQLBenchmarks, nested_transaction)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_nested_table (a int)"));
+    
+    const int helpers = 20000;
+    Transaction outer(_connection, _USQL_ENUM_VALUE(TransactionType, Immediate));
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < helpers; ++i) {
+        Transaction helper(_connection);
+        Cursor cursor("insert into bench_nested_table (a) values (?)", _connection);
+        cursor.bind(1, i);
+        cursor.exec();
+        if (i % 10) {
+            helper.commit();
+        }
+    }
+    report("nested transaction scopes", helpers, "scopes", seconds(begin));
+    ASSERT_TRUE(outer.commit());
+    
+    const Connection::TransactionStats &stats = _connection.transactionStats();
+    std::cout<<"[ BENCHMARK ] commit latency: "<<stats.totalCommitMilliseconds / stats.commits<<" ms avg, "<<stats.maxCommitMilliseconds<<" ms max"<<std::endl;
+    
+    Query query("select count(*) from bench_nested_table", _connection);
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(helpers - helpers / 10, query.intForColumnIndex(0));
+}
+
+TEST_F(USQLBenchmarks, busy_contention)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_busy_table (a int)"));
+    
+    const int threads = 4;
+    const int writes = 200;
+    std::vector<Histogram> waits(threads);
+    std::vector<int> failures(threads, 0);
+    std::vector<std::thread> workers;
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&waits, &failures, t, writes]() {
+            Connection con(_benchmark_db);
+            con.open();
+            con.setBusyPolicy(BusyPolicy::backoff(10000));
+            for (int i = 0; i < writes; ++i) {
+                if (!con.exec("insert into bench_busy_table (a) values (1)")) {
+                    ++failures[t];
+                }
+            }
+            
+            waits[t] = con.busyStats().waits;
+            con.close();
+        }));
+    }
+    for (auto iter = workers.begin(); iter != workers.end(); ++iter) {
+        iter->join();
+    }
+    report("contended writes", threads * writes, "writes", seconds(begin));
+    
+    Histogram total;
+    for (auto iter = waits.begin(); iter != waits.end(); ++iter) {
+        total.merge(*iter);
+    }
+    std::cout<<"[ BENCHMARK ] busy waits: "<<total.count()<<", p50 "<<total.percentile(0.5)<<" us, p99 "<<total.percentile(0.99)<<" us, max "<<total.maxMicroseconds()<<" us"<<std::endl;
+    
+    for (auto iter = failures.begin(); iter != failures.end(); ++iter) {
+        EXPECT_EQ(0, *iter);
+    }
+}
+
+TEST_F(USQLBenchmarks, open_profiles)
+{
+    _connection.close();
+    
+    const char *names[] = {"default", "read heavy", "write heavy", "ephemeral", "durable"};
+    const OpenProfile profiles[] = {
+        _USQL_ENUM_VALUE(OpenProfile, DefaultProfile),
+        _USQL_ENUM_VALUE(OpenProfile, ReadHeavy),
+        _USQL_ENUM_VALUE(OpenProfile, WriteHeavy),
+        _USQL_ENUM_VALUE(OpenProfile, Ephemeral),
+        _USQL_ENUM_VALUE(OpenProfile, Durable)
+    };
+    
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); ++p) {
+        std::remove(_benchmark_db);
+        std::remove((std::string(_benchmark_db) + "-wal").c_str());
+        std::remove((std::string(_benchmark_db) + "-shm").c_str());
+        
+        Connection con(_benchmark_db);
+        ASSERT_TRUE(con.open(profiles[p]));
+        ASSERT_TRUE(con.exec("create table bench_profile_table (a int, b real, c text)"));
+        
+        //one commit per row
+        const int commits = 500;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < commits; ++i) {
+            Cursor cursor("insert into bench_profile_table (a, b, c) values (?, ?, 'autocommit')", con);
+            cursor.bind(1, i);
+            cursor.bind(2, i * 0.5);
+            cursor.exec();
+        }
+        report(std::string(names[p]) + " profile, autocommit insert", commits, "rows", seconds(begin));
+        
+        const int rows = 100000;
+        begin = std::chrono::steady_clock::now();
+        con.transaction(_USQL_ENUM_VALUE(TransactionType, Immediate), [rows](Connection &c)->bool {
+            Cursor cursor("insert into bench_profile_table (a, b, c) values (?, ?, 'bulk insert text value')", c);
+            for (int i = 0; i < rows; ++i) {
+                cursor.bind(1, i);
+                cursor.bind(2, i * 0.5);
+                cursor.exec();
+            }
+            return true;
+        });
+        report(std::string(names[p]) + " profile, bulk insert", rows, "rows", seconds(begin));
+        
+        begin = std::chrono::steady_clock::now();
+        int64_t sum = 0;
+        int count = 0;
+        for (int n = 0; n < 5; ++n) {
+            Query query("select a, c from bench_profile_table", con);
+            while (query.next()) {
+                sum += query.intForColumnIndex(0);
+                ++count;
+            }
+        }
+        report(std::string(names[p]) + " profile, scan", count, "rows", seconds(begin));
+        
+        EXPECT_EQ((commits + rows) * 5, count);
+        con.close();
+    }
+    
+    std::remove((std::string(_benchmark_db) + "-wal").c_str());
+    std::remove((std::string(_benchmark_db) + "-shm").c_str());
+}
+
+TEST_F(USQLBenchmarks, background_checkpoint)
+{
+    const char *names[] = {"inline", "scheduled"};
+    for (int scheduled = 0; scheduled < 2; ++scheduled) {
+        std::remove(_benchmark_db);
+        std::remove((std::string(_benchmark_db) + "-wal").c_str());
+        std::remove((std::string(_benchmark_db) + "-shm").c_str());
+        
+        Connection con(_benchmark_db);
+        ASSERT_TRUE(con.open(_USQL_ENUM_VALUE(OpenProfile, ReadHeavy)));
+        con.setBusyPolicy(BusyPolicy::backoff(10000));
+        ASSERT_TRUE(con.exec("create table bench_checkpoint_table (a int, b text)"));
+        
+        CheckpointScheduler scheduler(con);
+        if (scheduled) {
+            ASSERT_TRUE(scheduler.start());
+        }
+        
+        //one commit per row, every commit's latency is recorded
+        const int commits = 20000;
+        const std::string text(1000, 'x');
+        Histogram latency;
+        Cursor cursor("insert into bench_checkpoint_table (a, b) values (?, ?)", con);
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < commits; ++i) {
+            auto write = std::chrono::steady_clock::now();
+            cursor.bindAllStatic(i, text);
+            EXPECT_TRUE(cursor.exec());
+            latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - write).count()));
+        }
+        report(std::string(names[scheduled]) + " checkpoint, autocommit insert", commits, "rows", seconds(begin));
+        std::cout<<"[ BENCHMARK ] "<<names[scheduled]<<" checkpoint, write latency: p50 "<<latency.percentile(0.5)<<" us, p99 "<<latency.percentile(0.99)<<" us, p99.9 "<<latency.percentile(0.999)<<" us, max "<<latency.maxMicroseconds()<<" us"<<std::endl;
+        
+        if (scheduled) {
+            scheduler.stop();
+            CheckpointScheduler::Stats stats = scheduler.stats();
+            std::cout<<"[ BENCHMARK ] checkpoints: "<<stats.durations.count()<<", "<<stats.framesCheckpointed<<" frames, p99 "<<stats.durations.percentile(0.99)<<" us, max "<<stats.durations.maxMicroseconds()<<" us"<<std::endl;
+        }
+        
+        cursor.close();
+        con.close();
+    }
+    
+    std::remove((std::string(_benchmark_db) + "-wal").c_str());
+    std::remove((std::string(_benchmark_db) + "-shm").c_str());
+}
+
+TEST_F(USQLBenchmarks, online_backup)
+{
+    const int rows = 200000;
+    ASSERT_TRUE(createWideTable(6, rows));
+    
+    //the copy this replaces, the source stays locked until the insert is done
+    const std::string copy = std::string(_benchmark_db) + ".copy";
+    std::remove(copy.c_str());
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_TRUE(_connection.attachDatabase(copy, "bench_copy"));
+    ASSERT_TRUE(_connection.exec("create table bench_copy.bench_wide_table as select * from main.bench_wide_table"));
+    _connection.detachDatabase("bench_copy");
+    report("attach + insert select copy", rows, "rows", seconds(begin));
+    std::remove(copy.c_str());
+    
+    const int steps[] = {-1, 1000, 100};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+        Connection::BackupOptions options;
+        options.pagesPerStep = steps[i];
+        Connection::BackupProgress last;
+        options.progress = [&last](const Connection::BackupProgress &progress)->bool {
+            last = progress;
+            return true;
+        };
+        
+        Connection replica(":memory:");
+        ASSERT_TRUE(replica.open());
+        begin = std::chrono::steady_clock::now();
+        ASSERT_TRUE(_connection.backupTo(replica, options));
+        double secs = seconds(begin);
+        report("backup to memory, " + std::to_string(steps[i]) + " pages per step", rows, "rows", secs);
+        std::cout<<"[ BENCHMARK ] backup to memory, "<<steps[i]<<" pages per step: "<<last.pageCount<<" pages, "<<last.steps<<" steps, "<<static_cast<int64_t>(last.pagesPerSecond())<<" pages/sec"<<std::endl;
+        replica.close();
+    }
+}
+
+TEST_F(USQLBenchmarks, blob_streaming)
+{
+    ASSERT_TRUE(_connection.exec("create table bench_blob_table (id integer primary key, data blob)"));
+    
+    const int size = 16 * 1024 * 1024;
+    const int chunk = 64 * 1024;
+    std::string payload(size, 'b');
+    const double megabytes = size / (1024.0 * 1024.0);
+    
+    //the whole blob is bound, and read back as one column value
+    sqlite3_memory_highwater(1);
+    auto begin = std::chrono::steady_clock::now();
+    {
+        Cursor cursor("insert into bench_blob_table (id, data) values (1, ?)", _connection);
+        cursor.bind(1, payload.data(), size, _USQL_ENUM_VALUE(BindType, Static));
+        ASSERT_TRUE(cursor.exec());
+    }
+    report("whole blob write", megabytes, "MB", seconds(begin));
+    
+    begin = std::chrono::steady_clock::now();
+    size_t total = 0;
+    {
+        Query query("select data from bench_blob_table where id = 1", _connection);
+        ASSERT_TRUE(query.next());
+        total = query.blobForColumnIndex(0).size();
+    }
+    report("whole blob read", megabytes, "MB", seconds(begin));
+    EXPECT_EQ(static_cast<size_t>(size), total);
+    std::cout<<"[ BENCHMARK ] whole blob, sqlite memory peak: "<<sqlite3_memory_highwater(1) / 1024<<" KB"<<std::endl;
+    
+    //preallocated with zeroblob and streamed through one chunk buffer
+    begin = std::chrono::steady_clock::now();
+    {
+        Cursor cursor("insert into bench_blob_table (id, data) values (2, ?)", _connection);
+        cursor.bindZeroBlob(1, size);
+        ASSERT_TRUE(cursor.exec());
+        
+        BlobStream stream(_connection);
+        ASSERT_TRUE(stream.open("bench_blob_table", "data", 2, true));
+        for (int offset = 0; offset < size; offset += chunk) {
+            ASSERT_TRUE(stream.write(payload.data() + offset, std::min(chunk, size - offset)));
+        }
+    }
+    report("streamed blob write", megabytes, "MB", seconds(begin));
+    
+    begin = std::chrono::steady_clock::now();
+    total = 0;
+    {
+        BlobStream stream(_connection);
+        ASSERT_TRUE(stream.open("bench_blob_table", "data", 2));
+        for (BlobView view = stream.readChunk(chunk); !view.empty(); view = stream.readChunk(chunk)) {
+            total += view.size();
+        }
+    }
+    report("streamed blob read", megabytes, "MB", seconds(begin));
+    EXPECT_EQ(static_cast<size_t>(size), total);
+    std::cout<<"[ BENCHMARK ] streamed blob, sqlite memory peak: "<<sqlite3_memory_highwater(1) / 1024<<" KB"<<std::endl;
+}
+
+TEST_F(USQLBenchmarks, statement_profiling)
+{
+    const int rows = 20000;
+    ASSERT_TRUE(_connection.exec("create table bench_profile_lookup (id integer primary key, a int)"));
+    BulkInserter inserter(_connection, "bench_profile_lookup", std::vector<std::string>(1, "a"));
+    for (int i = 0; i < rows; ++i) {
+        ASSERT_TRUE(inserter.insert(i));
+    }
+    ASSERT_TRUE(inserter.flush());
+    
+    const char *names[] = {"off", "on", "on without rows"};
+    for (int mode = 0; mode < 3; ++mode) {
+        _Profiler profiler;
+        if (mode > 0) {
+            ProfilerOptions options;
+            options.countRows = mode == 1;
+            profiler = _connection.enableProfiling(options);
+        }
+        
+        const int lookups = 200000;
+        int64_t sum = 0;
+        {
+            Query query("select a from bench_profile_lookup where id = ?", _connection);
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < lookups; ++i) {
+                query.bindAll(i % rows + 1);
+                if (query.next()) {
+                    sum += query.intForColumnIndex(0);
+                }
+            }
+            report(std::string("point lookup, profiling ") + names[mode], lookups, "lookups", seconds(begin));
+        }
+        EXPECT_EQ(static_cast<int64_t>(rows - 1) * rows / 2 * (lookups / rows), sum);
+        
+        if (profiler) {
+            auto begin = std::chrono::steady_clock::now();
+            std::vector<StatementProfile> profiles = profiler->snapshot();
+            double secs = seconds(begin);
+            ASSERT_FALSE(profiles.empty());
+            std::cout<<"[ BENCHMARK ] snapshot of "<<profiles.size()<<" statements: "<<secs * 1000000<<" us, lookup p99 "<<profiles[0].latency.percentile(0.99)<<" us"<<std::endl;
+            _connection.disableProfiling();
+        }
+    }
+}
+
+TEST_F(USQLBenchmarks, scalar_function_dispatch)
+{
+    Function *vector = Function::create("bench_mul_vector");
+    vector->setArgumentCount(2);
+    vector->setFunction([](sqlite3_context *context, std::vector<sqlite3_value *> &argv) {
+        sqlite3_result_double(context, sqlite3_value_double(argv[0]) * sqlite3_value_double(argv[1]));
+    });
+    ASSERT_TRUE(_connection.registerFunction(vector));
+    
+    Function *arguments = Function::create("bench_mul_arguments");
+    arguments->setArgumentCount(2);
+    arguments->setArgumentsFunction([](sqlite3_context *context, const FunctionArguments &argv) {
+        sqlite3_result_double(context, sqlite3_value_double(argv[0]) * sqlite3_value_double(argv[1]));
+    });
+    ASSERT_TRUE(_connection.registerFunction(arguments));
+    
+    ASSERT_TRUE(_connection.registerScalar<double(double, double)>("bench_mul_typed", [](double a, double b) {
+        return a * b;
+    }));
+    
+    const int rows = 1000000;
+    const char *functions[] = {"", "bench_mul_vector", "bench_mul_arguments", "bench_mul_typed"};
+    const char *names[] = {"builtin operator", "Function, vector argv", "Function, FunctionArguments", "registerScalar<double(double, double)>"};
+    for (int f = 0; f < 4; ++f) {
+        std::stringstream sql;
+        sql<<"with recursive r(x) as (select 1 union all select x + 1 from r where x < "<<rows<<") select sum(";
+        if (f == 0) {
+            sql<<"x * 0.5";
+        }
+        else {
+            sql<<functions[f]<<"(x, 0.5)";
+        }
+        sql<<") from r";
+        
+        AllocationCounter counter;
+        auto begin = std::chrono::steady_clock::now();
+        Query query(sql.str(), _connection);
+        ASSERT_TRUE(query.next());
+        double sum = query.floatForColumnIndex(0);
+        double secs = seconds(begin);
+        uint64_t allocations = counter.count();
+        
+        report(names[f], rows, "calls", secs);
+        std::cout<<"[ BENCHMARK ] "<<names[f]<<": "<<allocations<<" allocations"<<std::endl;
+        EXPECT_DOUBLE_EQ(static_cast<double>(rows) * (rows + 1) / 4, sum);
+    }
+}
+
+struct BenchAverage
+{
+    double sum;
+    int64_t count;
+    
+    BenchAverage() : sum(0), count(0) {}
+    
+    void step(double value) {
+        sum += value;
+        ++count;
+    }
+    
+    void inverse(double value) {
+        sum -= value;
+        --count;
+    }
+    
+    double value() const {
+        return count ? sum / count : 0;
+    }
+};
+
+TEST_F(USQLBenchmarks, grouped_aggregate)
+{
+    //the untyped aggregate keeps its state in sqlite3_aggregate_context by hand
+    AggregateFunction *untyped = AggregateFunction::create("bench_avg_untyped");
+    untyped->setArgumentCount(1);
+    untyped->setFunction([](sqlite3_context *context, std::vector<sqlite3_value *> &argv) {
+        BenchAverage *state = static_cast<BenchAverage *>(sqlite3_aggregate_context(context, sizeof(BenchAverage)));
+        state->step(sqlite3_value_double(argv[0]));
+    });
+    untyped->setFinalFunction([](sqlite3_context *context) {
+        BenchAverage *state = static_cast<BenchAverage *>(sqlite3_aggregate_context(context, 0));
+        sqlite3_result_double(context, state ? state->value() : 0);
+    });
+    ASSERT_TRUE(_connection.registerFunction(untyped));
+    ASSERT_TRUE(_connection.registerAggregate<BenchAverage>("bench_avg_typed"));
+    
+    const int rows = 1000000;
+    const int groups = 100000;
+    std::stringstream create;
+    create<<"create table bench_group_table as with recursive r(x) as (select 0 union all select x + 1 from r where x < "<<rows - 1<<") select x % "<<groups<<" as g, x * 0.5 as v from r";
+    ASSERT_TRUE(_connection.exec(create.str()));
+    
+    const char *functions[] = {"avg", "bench_avg_untyped", "bench_avg_typed"};
+    const char *names[] = {"builtin avg", "AggregateFunction", "registerAggregate<BenchAverage>"};
+    for (int f = 0; f < 3; ++f) {
+        std::string sql = std::string("select g, ") + functions[f] + "(v) from bench_group_table group by g";
+        AllocationCounter counter;
+        auto begin = std::chrono::steady_clock::now();
+        Query query(sql, _connection);
+        int count = 0;
+        double sum = 0;
+        while (query.next()) {
+            sum += query.floatForColumnIndex(1);
+            ++count;
+        }
+        double secs = seconds(begin);
+        uint64_t allocations = counter.count();
+        
+        report(std::string(names[f]) + ", group by", rows, "rows", secs);
+        std::cout<<"[ BENCHMARK ] "<<names[f]<<", group by: "<<count<<" groups, "<<allocations<<" allocations"<<std::endl;
+        EXPECT_EQ(groups, count);
+        EXPECT_DOUBLE_EQ(static_cast<double>(rows - 1) * rows / 4 / (rows / groups), sum);
+    }
+}
+
+#if _USQL_SQLITE_WINDOW_FUNCTION_ENABLE
+TEST_F(USQLBenchmarks, window_function)
+{
+    ASSERT_TRUE(_connection.registerWindow<BenchAverage>("bench_avg_window"));
+    //a plain aggregate may not be used over a window, the frame is rebuilt by a subquery per row
+    ASSERT_TRUE(_connection.registerAggregate<BenchAverage>("bench_avg_aggregate"));
+    
+    const int rows = 100000;
+    const int window = 100;
+    std::stringstream create;
+    create<<"insert into bench_window_table with recursive r(x) as (select 0 union all select x + 1 from r where x < "<<rows - 1<<") select x, (x % 1000) * 0.5 from r";
+    ASSERT_TRUE(_connection.exec("create table bench_window_table(x integer primary key, v real)"));
+    ASSERT_TRUE(_connection.exec(create.str()));
+    
+    std::stringstream over;
+    over<<" over (order by x rows between "<<window - 1<<" preceding and current row) from bench_window_table";
+    std::stringstream subquery;
+    subquery<<" from bench_window_table where x between t.x - "<<window - 1<<" and t.x) from bench_window_table t order by t.x";
+    
+    double expected = 0;
+    {
+        //rolling average buffered by the application
+        auto begin = std::chrono::steady_clock::now();
+        Query query("select v from bench_window_table order by x", _connection);
+        std::deque<double> values;
+        double sum = 0;
+        while (query.next()) {
+            double v = query.floatForColumnIndex(0);
+            values.push_back(v);
+            sum += v;
+            if (values.size() > static_cast<size_t>(window)) {
+                sum -= values.front();
+                values.pop_front();
+            }
+            expected += sum / values.size();
+        }
+        report("application deque", rows, "rows", seconds(begin));
+    }
+    
+    const std::string statements[] = {
+        "select avg(v)" + over.str(),
+        "select bench_avg_window(v)" + over.str(),
+        "select (select bench_avg_aggregate(v)" + subquery.str(),
+    };
+    const char *names[] = {"builtin avg() over", "registerWindow<BenchAverage> over", "registerAggregate<BenchAverage> subquery"};
+    for (int f = 0; f < 3; ++f) {
+        const std::string &sql = statements[f];
+        auto begin = std::chrono::steady_clock::now();
+        Query query(sql, _connection);
+        int count = 0;
+        double sum = 0;
+        while (query.next()) {
+            sum += query.floatForColumnIndex(0);
+            ++count;
+        }
+        report(names[f], rows, "rows", seconds(begin));
+        EXPECT_EQ(rows, count);
+        EXPECT_NEAR(expected, sum, 1e-6 * expected);
+    }
+}
+#endif
+
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+struct BenchPrice
+{
+    int64_t id;
+    std::string symbol;
+    double price;
+};
+
+TEST_F(USQLBenchmarks, container_table_join)
+{
+    const int rows = 200000;
+    const int orders = 50000;
+    std::vector<BenchPrice> prices(rows);
+    for (int i = 0; i < rows; ++i) {
+        prices[i].id = i;
+        prices[i].symbol = "symbol " + std::to_string(i);
+        prices[i].price = i * 0.25;
+    }
+    
+    std::stringstream create;
+    create<<"create table bench_order_table as with recursive r(x) as (select 0 union all select x + 1 from r where x < "<<orders - 1<<") select x, (x * 7919) % "<<rows<<" as price_id from r";
+    ASSERT_TRUE(_connection.exec(create.str()));
+    
+    double expected = 0;
+    {
+        //the copy a join needed before: a keyed table filled from the vector
+        auto begin = std::chrono::steady_clock::now();
+        ASSERT_TRUE(_connection.exec("create table bench_price_copy (id integer primary key, symbol text, price real)"));
+        std::vector<std::string> columns;
+        columns.push_back("id");
+        columns.push_back("symbol");
+        columns.push_back("price");
+        BulkInserter inserter(_connection, "bench_price_copy", columns);
+        for (auto iter = prices.begin(); iter != prices.end(); ++iter) {
+            ASSERT_TRUE(inserter.insert(iter->id, iter->symbol, iter->price));
+        }
+        ASSERT_TRUE(inserter.flush());
+        double copySecs = seconds(begin);
+        
+        Query query("select sum(p.price), count(p.symbol) from bench_order_table o join bench_price_copy p on p.id = o.price_id", _connection);
+        ASSERT_TRUE(query.next());
+        expected = query.floatForColumnIndex(0);
+        double secs = seconds(begin);
+        report("copied table, join", orders, "rows", secs - copySecs);
+        report("copied table, copy and join", orders, "rows", secs);
+    }
+    
+    const TableIndex indexes[] = {_USQL_ENUM_VALUE(TableIndex, Presorted), _USQL_ENUM_VALUE(TableIndex, Indexed)};
+    const char *names[] = {"ContainerTable presorted, join", "ContainerTable indexed, join"};
+    for (int i = 0; i < 2; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        auto table = ContainerTable<std::vector<BenchPrice> >::create(prices);
+        table->addColumn("id", &BenchPrice::id, indexes[i]).addColumn("symbol", &BenchPrice::symbol).addColumn("price", &BenchPrice::price);
+        ASSERT_TRUE(_connection.registerTable("bench_price_table", table));
+        
+        //the indexed column sorts its positions on the first lookup, inside the measured time
+        Query query("select sum(p.price), count(p.symbol) from bench_order_table o join bench_price_table p on p.id = o.price_id", _connection);
+        ASSERT_TRUE(query.next());
+        double secs = seconds(begin);
+        report(names[i], orders, "rows", secs);
+        EXPECT_DOUBLE_EQ(expected, query.floatForColumnIndex(0));
+        EXPECT_EQ(orders, query.intForColumnIndex(1));
+        query.close();
+        _connection.unregisterTable("bench_price_table");
+    }
+}
+#endif
+
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+TEST_F(USQLBenchmarks, array_in_list)
+{
+    const int rows = 100000;
+    std::stringstream create;
+    create<<"create table bench_in_table as with recursive r(x) as (select 0 union all select x + 1 from r where x < "<<rows - 1<<") select x as id, x * 0.5 as v from r";
+    ASSERT_TRUE(_connection.exec(create.str()));
+    ASSERT_TRUE(_connection.exec("create index bench_in_index on bench_in_table(id)"));
+    
+    const int sizes[] = {10, 100, 1000, 5000};
+    for (int s = 0; s < 4; ++s) {
+        const int queries = 200000 / sizes[s] + 20;
+        std::vector<std::vector<int64_t> > lists(queries);
+        for (int q = 0; q < queries; ++q) {
+            for (int i = 0; i < sizes[s]; ++i) {
+                lists[q].push_back((static_cast<int64_t>(q) * 7919 + i * 104729) % rows);
+            }
+        }
+        
+        //a new sql text for every list, each one is prepared and fills the statement cache
+        double expected = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            std::stringstream sql;
+            sql<<"select sum(v) from bench_in_table where id in (";
+            for (int i = 0; i < sizes[s]; ++i) {
+                sql<<(i ? "," : "")<<lists[q][i];
+            }
+            sql<<")";
+            Query query(sql.str(), _connection);
+            ASSERT_TRUE(query.next());
+            expected += query.floatForColumnIndex(0);
+        }
+        report("in list of " + std::to_string(sizes[s]) + ", sql text", queries, "queries", seconds(begin));
+        
+        double sum = 0;
+        begin = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            Query query("select sum(v) from bench_in_table where id in usql_array(?)", _connection);
+            query.bind(1, lists[q]);
+            ASSERT_TRUE(query.next());
+            sum += query.floatForColumnIndex(0);
+        }
+        report("in list of " + std::to_string(sizes[s]) + ", usql_array", queries, "queries", seconds(begin));
+        EXPECT_DOUBLE_EQ(expected, sum);
+    }
+}
+#endif
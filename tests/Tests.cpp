@@ -28,9 +28,110 @@
 #include "USQL.hpp"
 #include <sstream>
 #include <cstdio>
+#include <thread>
+#include <stdexcept>
+#include <atomic>
+#include <ctime>
 
 using namespace usql;
 
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+struct TestRow
+{
+    std::string a;
+    int b;
+    double c;
+};
+
+namespace usql {
+    template<>
+    struct RowDecoder<TestRow> {
+        static void decode(RowReader &row, TestRow &value) {
+            row>>value.a>>value.b>>value.c;
+        }
+    };
+}
+
+//aggregate states, live counts every constructed and not yet destroyed state
+struct TestConcat
+{
+    static int live;
+    std::string text;
+    std::string separator;
+    
+    TestConcat(const std::string &sep = ",") : separator(sep) {
+        ++live;
+    }
+    TestConcat(const TestConcat &other) : text(other.text), separator(other.separator) {
+        ++live;
+    }
+    ~TestConcat() {
+        --live;
+    }
+    
+    void step(TextView value) {
+        if (!text.empty()) {
+            text += separator;
+        }
+        text += value.str();
+    }
+    
+    const std::string &value() const {
+        return text;
+    }
+};
+int TestConcat::live = 0;
+
+struct TestAverage
+{
+    double sum;
+    int64_t count;
+    
+    TestAverage() : sum(0), count(0) {}
+    
+    void step(double value) {
+        sum += value;
+        ++count;
+    }
+    
+    void inverse(double value) {
+        sum -= value;
+        --count;
+    }
+    
+    double value() const {
+        return count ? sum / count : 0;
+    }
+};
+
+struct TestPerson
+{
+    int64_t id;
+    std::string name;
+    double score;
+    
+    TestPerson(int64_t i, const std::string &n, double s) : id(i), name(n), score(s) {}
+};
+
+struct TestPositiveSum
+{
+    int64_t sum;
+    
+    TestPositiveSum() : sum(0) {}
+    
+    void step(int value) {
+        if (value < 0) {
+            throw std::runtime_error("negative value");
+        }
+        sum += value;
+    }
+    
+    int64_t value() const {
+        return sum;
+    }
+};
+#endif
+
 #ifdef _MSC_VER
 static const char *_db = "usqlite.db";
 static const char *_test1 = "usqlite_test1.db";
@@ -60,6 +161,80 @@ TEST(usqlite_tests, open_close_database)
     EXPECT_TRUE(connection.isOpenning());
 }
 
+TEST(usqlite_tests, open_profile)
+{
+    auto pragma = [](Connection &con, const std::string &name)->std::string {
+        Query query("SELECT CAST(" + name + " AS TEXT) FROM pragma_" + name, con);
+        return query.next() ? query.textForColumnIndex(0) : "";
+    };
+    
+    std::remove(_test1);
+    {
+        Connection con(_test1);
+        EXPECT_TRUE(con.open(_USQL_ENUM_VALUE(OpenProfile, ReadHeavy)));
+        EXPECT_EQ("wal", pragma(con, "journal_mode"));
+        EXPECT_EQ("1", pragma(con, "synchronous"));
+        EXPECT_EQ("-65536", pragma(con, "cache_size"));
+        EXPECT_EQ("2", pragma(con, "temp_store"));
+        EXPECT_EQ("4096", pragma(con, "page_size"));
+        
+        Query checkpoint("PRAGMA wal_autocheckpoint", con);
+        EXPECT_TRUE(checkpoint.next());
+        EXPECT_EQ(1000, checkpoint.intForColumnIndex(0));
+        checkpoint.close();
+        EXPECT_TRUE(con.close());
+    }
+    std::remove(_test1);
+    
+    {
+        Connection con(_test1);
+        EXPECT_TRUE(con.open(_USQL_ENUM_VALUE(OpenProfile, Ephemeral)));
+        EXPECT_EQ("memory", pragma(con, "journal_mode"));
+        EXPECT_EQ("0", pragma(con, "synchronous"));
+        EXPECT_TRUE(con.close());
+    }
+    std::remove(_test1);
+    
+    {
+        PragmaProfile profile = PragmaProfile::profile(_USQL_ENUM_VALUE(OpenProfile, Durable));
+        profile.cacheSize = -1;
+        EXPECT_EQ(4, profile.commands().size());
+        
+        Connection con(_test1);
+        EXPECT_TRUE(con.open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, profile));
+        EXPECT_EQ("wal", pragma(con, "journal_mode"));
+        EXPECT_EQ("2", pragma(con, "synchronous"));
+        EXPECT_EQ("-1", pragma(con, "cache_size"));
+        EXPECT_TRUE(con.close());
+    }
+    std::remove(_test1);
+    
+    EXPECT_TRUE(PragmaProfile::profile(_USQL_ENUM_VALUE(OpenProfile, DefaultProfile)).commands().empty());
+    
+    //a failing pragma leaves the connection closed
+    PragmaProfile bad;
+    bad.tempStore = "(";
+    Connection con(_test1);
+    EXPECT_FALSE(con.open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, bad));
+    EXPECT_FALSE(con.isOpenning());
+    
+    //a profile asked of an open connection is applied to it
+    ASSERT_TRUE(con.open());
+    EXPECT_EQ("delete", pragma(con, "journal_mode"));
+    EXPECT_TRUE(con.open(_USQL_ENUM_VALUE(OpenProfile, ReadHeavy)));
+    EXPECT_EQ("wal", pragma(con, "journal_mode"));
+    EXPECT_EQ("1", pragma(con, "synchronous"));
+    EXPECT_EQ("-65536", pragma(con, "cache_size"));
+    
+    //and a failing pragma leaves it open
+    EXPECT_FALSE(con.open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, bad));
+    EXPECT_TRUE(con.isOpenning());
+    EXPECT_TRUE(con.close());
+    std::remove(_test1);
+    std::remove((std::string(_test1) + "-wal").c_str());
+    std::remove((std::string(_test1) + "-shm").c_str());
+}
+
 TEST(usqlite_tests, attach_detach_database)
 {
     Connection con(_test1);
@@ -100,6 +275,569 @@ TEST(usqlite_tests, attach_detach_database)
     std::remove(_test2);
 }
 
+TEST(usqlite_tests, backup_restore)
+{
+    std::remove(_test1);
+    std::remove(_test2);
+    Connection con(_test1);
+    ASSERT_TRUE(con.open());
+    ASSERT_TRUE(con.exec("create table backup_table (a int, b text)"));
+    ASSERT_TRUE(con.transaction(_USQL_ENUM_VALUE(TransactionType, Immediate), [](Connection &c)->bool {
+        Cursor cursor("insert into backup_table (a, b) values (?, ?)", c);
+        for (int i = 0; i < 1000; ++i) {
+            cursor.bindAll(i, std::string(200, 'x'));
+            if (!cursor.exec()) {
+                return false;
+            }
+        }
+        return true;
+    }));
+    
+    //a few pages per step, progress is reported after every step
+    Connection::BackupOptions options;
+    options.pagesPerStep = 5;
+    std::vector<Connection::BackupProgress> steps;
+    options.progress = [&steps](const Connection::BackupProgress &progress)->bool {
+        steps.push_back(progress);
+        return true;
+    };
+    
+    Connection replica(":memory:");
+    ASSERT_TRUE(replica.open());
+    EXPECT_TRUE(replica.restoreFrom(con, options));
+    ASSERT_LT(2, steps.size());
+    EXPECT_EQ(0, steps.back().remaining);
+    EXPECT_EQ(steps.back().pageCount, steps.back().pagesCopied);
+    EXPECT_EQ(5, steps.front().pagesCopied);
+    for (size_t i = 1; i < steps.size(); ++i) {
+        EXPECT_LE(steps[i - 1].pagesCopied, steps[i].pagesCopied);
+    }
+    
+    {
+        Query query("select count(*), sum(a) from backup_table", replica);
+        EXPECT_TRUE(query.next());
+        EXPECT_EQ(1000, query.intForColumnIndex(0));
+        EXPECT_EQ(999 * 1000 / 2, query.intForColumnIndex(1));
+    }
+    
+    //back into a file and restored from it
+    EXPECT_TRUE(replica.exec("delete from backup_table where a >= 500"));
+    EXPECT_TRUE(replica.backupTo(_test2));
+    EXPECT_TRUE(con.restoreFrom(_test2));
+    {
+        Query query("select count(*) from backup_table", con);
+        EXPECT_TRUE(query.next());
+        EXPECT_EQ(500, query.intForColumnIndex(0));
+    }
+    
+    //a cancelled backup leaves the destination alone
+    Connection other(":memory:");
+    ASSERT_TRUE(other.open());
+    options.progress = [](const Connection::BackupProgress &)->bool {
+        return false;
+    };
+    Result ret = con.backupTo(other, options);
+    EXPECT_FALSE(ret);
+    EXPECT_EQ(SQLITE_ABORT, ret.code());
+    EXPECT_FALSE(other.tableExists("backup_table"));
+    
+    //a source held by an exclusive lock gives up after busyTimeout instead of spinning
+    {
+        Connection locker(_test1);
+        ASSERT_TRUE(locker.open());
+        ASSERT_TRUE(locker.beginTransaction(_USQL_ENUM_VALUE(TransactionType, Exclusive)));
+        
+        Connection::BackupOptions busy;
+        busy.busyTimeout = 100;
+        auto begin = std::chrono::steady_clock::now();
+        ret = con.backupTo(other, busy);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        EXPECT_FALSE(ret);
+        EXPECT_EQ(SQLITE_BUSY, ret.code());
+        EXPECT_LE(0.1, seconds);
+        EXPECT_GT(2.0, seconds);
+        
+        ASSERT_TRUE(locker.rollback());
+        EXPECT_TRUE(con.backupTo(other, busy));
+        EXPECT_TRUE(other.tableExists("backup_table"));
+        locker.close();
+    }
+    
+    Connection closed(":memory:");
+    EXPECT_FALSE(con.backupTo(closed));
+    
+    other.close();
+    replica.close();
+    con.close();
+    std::remove(_test1);
+    std::remove(_test2);
+}
+
+TEST(usqlite_tests, statement_profiler)
+{
+    Connection con(":memory:");
+    ASSERT_TRUE(con.open());
+    EXPECT_TRUE(con.profiler() == nullptr);
+    
+    ProfilerOptions options;
+    options.slowQueryThreshold = 0;
+    options.slowQueryLogSize = 2;
+    options.expandSlowQueries = true;
+    std::vector<std::string> logged;
+    options.slowQueryHandler = [&logged](const SlowQuery &query) {
+        logged.push_back(query.sql);
+    };
+    _Profiler profiler = con.enableProfiling(options);
+    ASSERT_TRUE(profiler != nullptr);
+    EXPECT_EQ(profiler, con.profiler());
+    
+    ASSERT_TRUE(con.exec("create table profile_table (a int, b int)"));
+    const std::string insert = "insert into profile_table (a, b) values (?, ?)";
+    for (int i = 0; i < 10; ++i) {
+        Cursor cursor(insert, con);
+        cursor.bindAll(i, i % 3);
+        EXPECT_TRUE(cursor.exec());
+    }
+    
+    const std::string select = "select a from profile_table where b = 1 order by a desc";
+    for (int i = 0; i < 2; ++i) {
+        Query query(select, con);
+        int rows = 0;
+        while (query.next()) {
+            ++rows;
+        }
+        EXPECT_EQ(3, rows);
+    }
+    
+    std::vector<StatementProfile> profiles = profiler->snapshot();
+    ASSERT_EQ(3, profiles.size());
+    for (size_t i = 1; i < profiles.size(); ++i) {
+        EXPECT_GE(profiles[i - 1].latency.totalMicroseconds(), profiles[i].latency.totalMicroseconds());
+    }
+    
+    const StatementProfile *inserted = nullptr;
+    const StatementProfile *selected = nullptr;
+    for (auto iter = profiles.begin(); iter != profiles.end(); ++iter) {
+        if (iter->sql == insert) {
+            inserted = &*iter;
+        }
+        else if (iter->sql == select) {
+            selected = &*iter;
+        }
+    }
+    ASSERT_TRUE(inserted && selected);
+    EXPECT_EQ(10, inserted->executions);
+    EXPECT_EQ(10, inserted->latency.count());
+    EXPECT_EQ(0, inserted->rows);
+    EXPECT_EQ(2, selected->executions);
+    EXPECT_EQ(6, selected->rows);
+    EXPECT_EQ(2 * 9, selected->counters.fullscanSteps);
+    EXPECT_EQ(2, selected->counters.sorts);
+    EXPECT_LT(0, selected->counters.vmSteps);
+    EXPECT_LT(0, selected->maxMemory);
+    EXPECT_EQ(2, selected->slowExecutions);
+    
+    //every execution was slow, the log keeps the last two
+    EXPECT_EQ(13, logged.size());
+    EXPECT_EQ("insert into profile_table (a, b) values (0, 0)", logged[1]);
+    std::vector<SlowQuery> slow = profiler->slowQueries();
+    ASSERT_EQ(2, slow.size());
+    EXPECT_EQ(select, slow[1].sql);
+    EXPECT_EQ(3, slow[1].rows);
+    EXPECT_EQ(1, slow[1].counters.sorts);
+    
+    profiler->reset();
+    EXPECT_TRUE(profiler->snapshot().empty());
+    EXPECT_TRUE(profiler->slowQueries().empty());
+    
+    //further sql texts are summed up
+    options = ProfilerOptions();
+    options.maxStatements = 1;
+    profiler = con.enableProfiling(options);
+    EXPECT_TRUE(con.exec("select 1"));
+    EXPECT_TRUE(con.exec("select 2"));
+    EXPECT_TRUE(con.exec("select 3"));
+    profiles = profiler->snapshot();
+    ASSERT_EQ(2, profiles.size());
+    EXPECT_EQ(3, profiles[0].executions + profiles[1].executions);
+    
+    con.disableProfiling();
+    EXPECT_TRUE(con.profiler() == nullptr);
+    EXPECT_TRUE(con.exec("select 4"));
+    profiles = profiler->snapshot();
+    EXPECT_EQ(3, profiles[0].executions + profiles[1].executions);
+    con.close();
+}
+
+TEST(usqlite_tests, connection_pool)
+{
+    std::remove(_test1);
+    ConnectionPool pool(_test1, 2);
+    EXPECT_TRUE(pool.open());
+    EXPECT_TRUE(pool.isOpenning());
+    
+    {
+        auto writer = pool.writer();
+        ASSERT_TRUE(writer.valid());
+        EXPECT_TRUE(writer.isWriter());
+        EXPECT_TRUE(writer->exec("create table pool_table (a int)"));
+        EXPECT_TRUE(writer->exec("insert into pool_table (a) values (1), (2), (3)"));
+        
+        Query mode("PRAGMA journal_mode", *writer);
+        EXPECT_TRUE(mode.next());
+        EXPECT_EQ("wal", mode.textForColumnIndex(0));
+        
+        //only one writer
+        EXPECT_FALSE(pool.writer(10).valid());
+    }
+    
+    {
+        auto r1 = pool.reader();
+        auto r2 = pool.reader();
+        EXPECT_TRUE(r1.valid());
+        EXPECT_TRUE(r2.valid());
+        EXPECT_FALSE(r1->exec("insert into pool_table (a) values (4)"));
+        
+        //pool exhausted
+        auto r3 = pool.reader(10);
+        EXPECT_FALSE(r3.valid());
+        EXPECT_EQ(2, pool.stats().readersInUse);
+        EXPECT_FALSE(pool.close());
+        
+        //a lease returned from another thread wakes the waiter
+        std::thread t([&r2]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            r2.release();
+        });
+        r3 = pool.reader(1000);
+        EXPECT_TRUE(r3.valid());
+        t.join();
+    }
+    
+    std::vector<std::thread> threads;
+    std::vector<int64_t> sums(4, 0);
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(std::thread([&pool, &sums, i]() {
+            for (int n = 0; n < 50; ++n) {
+                auto reader = pool.reader();
+                if (!reader) {
+                    continue;
+                }
+                
+                Query query("select sum(a) from pool_table", *reader);
+                if (query.next()) {
+                    sums[i] += query.intForColumnIndex(0);
+                }
+            }
+        }));
+    }
+    for (auto iter = threads.begin(); iter != threads.end(); ++iter) {
+        iter->join();
+    }
+    for (auto iter = sums.begin(); iter != sums.end(); ++iter) {
+        EXPECT_EQ(300, *iter);
+    }
+    
+    auto stats = pool.stats();
+    EXPECT_EQ(2, stats.readers);
+    EXPECT_EQ(0, stats.readersInUse);
+    EXPECT_EQ(2, stats.peakReadersInUse);
+    EXPECT_EQ(203, stats.readerLeases);
+    EXPECT_EQ(1, stats.writerLeases);
+    EXPECT_EQ(2, stats.timeouts);
+    EXPECT_LE(1, stats.waits);
+    EXPECT_TRUE(stats.readerUtilisation > 0 && stats.readerUtilisation <= 1);
+    
+    EXPECT_TRUE(pool.close());
+    EXPECT_FALSE(pool.isOpenning());
+    EXPECT_FALSE(pool.reader().valid());
+    
+    std::remove(_test1);
+}
+
+TEST(usqlite_tests, write_queue)
+{
+    std::remove(_test1);
+    Connection con(_test1);
+    ASSERT_TRUE(con.open());
+    ASSERT_TRUE(con.exec("create table queue_table (a int unique)"));
+    
+    WriteQueue queue(con);
+    EXPECT_FALSE(queue.enqueue("insert into queue_table (a) values (-1)").get());
+    EXPECT_TRUE(queue.start());
+    EXPECT_TRUE(queue.isRunning());
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([&queue, t]() {
+            std::vector<std::future<Result>> futures;
+            for (int i = 0; i < 100; ++i) {
+                int value = t * 100 + i;
+                futures.push_back(queue.enqueue([value](Connection &con)->Result {
+                    Cursor cursor("insert into queue_table (a) values (?)", con);
+                    cursor.bind(1, value);
+                    return cursor.exec();
+                }));
+            }
+            
+            for (auto iter = futures.begin(); iter != futures.end(); ++iter) {
+                EXPECT_TRUE(iter->get());
+            }
+        }));
+    }
+    for (auto iter = threads.begin(); iter != threads.end(); ++iter) {
+        iter->join();
+    }
+    
+    //a failing write is rolled back alone
+    auto dup = queue.enqueue("insert into queue_table (a) values (1)");
+    auto ok = queue.enqueue("insert into queue_table (a) values (400)");
+    EXPECT_FALSE(dup.get());
+    EXPECT_TRUE(ok.get());
+    
+    //a throwing task reports the exception and leaves nothing behind
+    auto thrown = queue.enqueue([](Connection &con)->Result {
+        con.exec("insert into queue_table (a) values (500)");
+        throw std::runtime_error("write queue task failed");
+    });
+    Result ret = thrown.get();
+    EXPECT_FALSE(ret);
+    EXPECT_EQ("write queue task failed", ret.description());
+    EXPECT_TRUE(queue.enqueue("insert into queue_table (a) values (500)").get());
+    EXPECT_TRUE(queue.enqueue("delete from queue_table where a = 500").get());
+    
+    queue.stop();
+    EXPECT_FALSE(queue.isRunning());
+    EXPECT_EQ(405, queue.writeCount());
+    EXPECT_LE(1, queue.commitCount());
+    EXPECT_GE(405, queue.commitCount());
+    
+    Query query("select count(*), sum(a) from queue_table", con);
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(401, query.intForColumnIndex(0));
+    EXPECT_EQ(400 * 401 / 2, query.intForColumnIndex(1));
+    
+    con.close();
+    std::remove(_test1);
+}
+
+TEST(usqlite_tests, write_queue_stop_race)
+{
+    std::remove(_test1);
+    Connection con(_test1);
+    ASSERT_TRUE(con.open());
+    ASSERT_TRUE(con.exec("create table queue_table (a int)"));
+    
+    //every future is ready after stop(), written or refused
+    for (int round = 0; round < 20; ++round) {
+        WriteQueue queue(con);
+        ASSERT_TRUE(queue.start());
+        
+        std::atomic<bool> go(false);
+        std::vector<std::vector<std::future<Result>>> futures(4);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.push_back(std::thread([&queue, &futures, &go, t]() {
+                while (!go) {
+                    std::this_thread::yield();
+                }
+                for (int i = 0; i < 200; ++i) {
+                    futures[t].push_back(queue.enqueue("insert into queue_table (a) values (1)"));
+                }
+            }));
+        }
+        
+        go = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(round * 50));
+        queue.stop();
+        for (auto iter = threads.begin(); iter != threads.end(); ++iter) {
+            iter->join();
+        }
+        
+        uint64_t written = 0;
+        for (auto list = futures.begin(); list != futures.end(); ++list) {
+            for (auto iter = list->begin(); iter != list->end(); ++iter) {
+                ASSERT_EQ(std::future_status::ready, iter->wait_for(std::chrono::seconds(0)));
+                Result ret = iter->get();
+                if (ret) {
+                    ++written;
+                }
+                else {
+                    EXPECT_EQ(SQLITE_MISUSE, ret.code());
+                }
+            }
+        }
+        EXPECT_EQ(queue.writeCount(), written);
+    }
+    
+    con.close();
+    std::remove(_test1);
+}
+
+TEST(usqlite_tests, checkpoint_scheduler)
+{
+    std::remove(_test1);
+    std::remove((std::string(_test1) + "-wal").c_str());
+    Connection con(_test1);
+    ASSERT_TRUE(con.open(_USQL_ENUM_VALUE(OpenProfile, WriteHeavy)));
+    ASSERT_TRUE(con.exec("create table checkpoint_table (a int, b text)"));
+    
+    {
+        Connection rollback(_test2);
+        ASSERT_TRUE(rollback.open());
+        CheckpointScheduler scheduler(rollback);
+        EXPECT_FALSE(scheduler.start());
+        EXPECT_FALSE(scheduler.isRunning());
+        rollback.close();
+        std::remove(_test2);
+    }
+    
+    con.setBusyPolicy(BusyPolicy::backoff(5000));
+    CheckpointScheduler scheduler(con);
+    EXPECT_FALSE(scheduler.checkpoint(_USQL_ENUM_VALUE(CheckpointMode, Passive)));
+    scheduler.setWalFrames(50);
+    scheduler.setIdleTime(100);
+    EXPECT_TRUE(scheduler.start());
+    EXPECT_TRUE(scheduler.isRunning());
+    
+    {
+        Query query("PRAGMA wal_autocheckpoint", con);
+        EXPECT_TRUE(query.next());
+        EXPECT_EQ(0, query.intForColumnIndex(0));
+    }
+    
+    Cursor cursor("insert into checkpoint_table (a, b) values (?, ?)", con);
+    std::string text(1000, 'x');
+    for (int i = 0; i < 500; ++i) {
+        cursor.bindAll(i, text);
+        EXPECT_TRUE(cursor.exec());
+    }
+    
+    //the writer only reports the wal, the scheduler thread checkpoints it
+    CheckpointScheduler::Stats stats = scheduler.stats();
+    EXPECT_LT(0, stats.walFrames);
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stats = scheduler.stats();
+    EXPECT_LE(1, stats.passiveCheckpoints + stats.restartCheckpoints + stats.truncateCheckpoints);
+    EXPECT_LE(1, stats.truncateCheckpoints);
+    EXPECT_LT(0, stats.framesCheckpointed);
+    EXPECT_EQ(stats.passiveCheckpoints + stats.restartCheckpoints + stats.truncateCheckpoints, stats.durations.count());
+    
+    //an idle writer with nothing left to truncate must not keep the scheduler thread busy
+    std::clock_t cpu = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_GT(CLOCKS_PER_SEC / 10, std::clock() - cpu);
+    
+    EXPECT_TRUE(scheduler.checkpoint(_USQL_ENUM_VALUE(CheckpointMode, Truncate)));
+    EXPECT_EQ(0, scheduler.stats().lastLogFrames);
+    
+    scheduler.stop();
+    EXPECT_FALSE(scheduler.isRunning());
+    {
+        Query query("PRAGMA wal_autocheckpoint", con);
+        EXPECT_TRUE(query.next());
+        EXPECT_EQ(10000, query.intForColumnIndex(0));
+    }
+    
+    Query query("select count(*) from checkpoint_table", con);
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(500, query.intForColumnIndex(0));
+    query.close();
+    
+    con.close();
+    std::remove(_test1);
+}
+
+TEST(usqlite_tests, busy_policy)
+{
+    std::remove(_test1);
+    Connection holder(_test1);
+    Connection waiter(_test1);
+    ASSERT_TRUE(holder.open());
+    ASSERT_TRUE(waiter.open());
+    ASSERT_TRUE(holder.exec("create table busy_table (a int)"));
+    
+    //no policy, fails at once
+    ASSERT_TRUE(holder.beginTransaction(_USQL_ENUM_VALUE(TransactionType, Immediate)));
+    Result ret = waiter.exec("insert into busy_table (a) values (1)");
+    EXPECT_EQ(SQLITE_BUSY, ret.code());
+    EXPECT_EQ(0, waiter.busyStats().retries);
+    
+    //gives up after the timeout
+    waiter.setBusyPolicy(BusyPolicy::backoff(50));
+    auto begin = std::chrono::steady_clock::now();
+    ret = waiter.exec("insert into busy_table (a) values (1)");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    EXPECT_EQ(SQLITE_BUSY, ret.code());
+    EXPECT_LE(50, elapsed);
+    EXPECT_EQ(1, waiter.busyStats().timeouts);
+    EXPECT_LT(0, waiter.busyStats().retries);
+    EXPECT_EQ(1, waiter.busyStats().waits.count());
+    
+    //succeeds once the lock is released
+    waiter.resetBusyStats();
+    waiter.setBusyPolicy(BusyPolicy::backoff(5000));
+    std::thread t([&holder]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        holder.commit();
+    });
+    EXPECT_TRUE(waiter.exec("insert into busy_table (a) values (1)"));
+    t.join();
+    
+    const BusyStats &stats = waiter.busyStats();
+    EXPECT_EQ(0, stats.timeouts);
+    EXPECT_EQ(1, stats.waits.count());
+    EXPECT_LE(20000, stats.waits.maxMicroseconds());
+    EXPECT_GE(stats.waits.maxMicroseconds(), stats.waits.percentile(0.99));
+    
+    //kept across reopen
+    EXPECT_TRUE(waiter.close());
+    EXPECT_TRUE(waiter.open());
+    EXPECT_EQ(5000, waiter.busyPolicy().timeout);
+    
+    holder.close();
+    waiter.close();
+    std::remove(_test1);
+}
+
+#if _USQL_SQLITE_UNLOCK_NOTIFY_ENABLE
+TEST(usqlite_tests, busy_unlock_notify)
+{
+    std::remove(_test1);
+    Connection holder(_test1);
+    Connection waiter(_test1);
+    ASSERT_TRUE(holder.open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_SHAREDCACHE));
+    ASSERT_TRUE(waiter.open(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_SHAREDCACHE));
+    ASSERT_TRUE(holder.exec("create table locked_table (a int)"));
+    
+    ASSERT_TRUE(holder.beginTransaction(_USQL_ENUM_VALUE(TransactionType, Deferred)));
+    ASSERT_TRUE(holder.exec("insert into locked_table (a) values (1)"));
+    Result ret = waiter.exec("select * from locked_table");
+    EXPECT_EQ(SQLITE_LOCKED, ret.code());
+    
+    BusyPolicy policy = BusyPolicy::backoff(5000);
+    policy.unlockNotify = true;
+    waiter.setBusyPolicy(policy);
+    std::thread t([&holder]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        holder.commit();
+    });
+    Query query("select count(*) from locked_table", waiter);
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(1, query.intForColumnIndex(0));
+    t.join();
+    
+    EXPECT_EQ(1, waiter.busyStats().unlockNotifications);
+    EXPECT_EQ(1, waiter.busyStats().waits.count());
+    
+    query.close();
+    holder.close();
+    waiter.close();
+    std::remove(_test1);
+}
+#endif
+
 #pragma mark - sqlite base tests
 class USQLTests : public testing::Test
 {
@@ -255,6 +993,15 @@ TEST_F(USQLTests, fail_on_closed_database)
 TEST_F(USQLTests, fail_on_bad_statement)
 {
     EXPECT_FALSE(_connection.exec("bla bla bla"));
+    
+    Result ret = _connection.exec("select * from no_such_table");
+    EXPECT_FALSE(ret);
+    EXPECT_EQ(SQLITE_ERROR, ret.code());
+    EXPECT_EQ("no such table: no_such_table", ret.description());
+    
+    Result copy = ret;
+    EXPECT_EQ(ret.description(), copy.description());
+    EXPECT_EQ("not an error", Result::success().description());
 }
 
 TEST_F(USQLTests, success_exe_sql)
@@ -359,6 +1106,126 @@ TEST_F(USQLTests, query_text)
     EXPECT_FALSE(query.next());
 }
 
+TEST_F(USQLTests, query_text_view)
+{
+    EXPECT_TRUE(insertRow("hello world", 10, 12.3));
+    
+    Query query("select * from use_sqlite_table", _connection);
+    EXPECT_TRUE(query.next());
+    
+    TextView text = query.textViewForName("a");
+    EXPECT_FALSE(text.isNull());
+    EXPECT_EQ(11, text.size());
+    EXPECT_EQ("hello world", text.str());
+    
+    EXPECT_TRUE(query.textViewForName("b").isNull());
+    EXPECT_TRUE(query.textViewForName("A").isNull());
+    
+    EXPECT_FALSE(query.next());
+#if _USQL_VIEW_GUARD_ENABLE
+    EXPECT_FALSE(text.valid());
+#endif
+}
+
+TEST_F(USQLTests, query_blob)
+{
+    Cursor cursor("insert into use_sqlite_table (a, d) values (:a, :d)", _connection);
+    const char bytes[] = {'b', 0, 'l', 0, 'o', 'b'};
+    EXPECT_TRUE(cursor.bind(":a", std::string("blob row")));
+    EXPECT_TRUE(cursor.bind(":d", bytes, sizeof(bytes)));
+    EXPECT_TRUE(cursor.exec());
+    
+    Query query("select * from use_sqlite_table", _connection);
+    EXPECT_TRUE(query.next());
+    
+    BlobView blob = query.blobForName("d");
+    EXPECT_EQ(sizeof(bytes), blob.size());
+    EXPECT_EQ(std::string(bytes, sizeof(bytes)), blob.str());
+    EXPECT_TRUE(query.blobForName("a").isNull());
+    EXPECT_TRUE(blob.valid());
+    
+    EXPECT_TRUE(query.reset());
+#if _USQL_VIEW_GUARD_ENABLE
+    EXPECT_FALSE(blob.valid());
+#endif
+}
+
+TEST_F(USQLTests, blob_stream)
+{
+    //preallocated with zeroblob and streamed in
+    const int size = 200000;
+    std::string payload(size, 0);
+    for (int i = 0; i < size; ++i) {
+        payload[i] = static_cast<char>(i * 7);
+    }
+    
+    Cursor cursor("insert into use_sqlite_table (a, d) values (:a, :d)", _connection);
+    EXPECT_TRUE(cursor.bind(":a", std::string("stream")));
+    EXPECT_TRUE(cursor.bindZeroBlob(":d", size));
+    EXPECT_TRUE(cursor.exec());
+    sqlite3_int64 rowid = _connection.lastInsertRowId();
+    EXPECT_LT(0, rowid);
+    
+    EXPECT_TRUE(cursor.bind(":a", std::string("small")));
+    EXPECT_TRUE(cursor.bindZeroBlob(":d", 4));
+    EXPECT_TRUE(cursor.exec());
+    sqlite3_int64 small = _connection.lastInsertRowId();
+    EXPECT_FALSE(cursor.bindZeroBlob(":d", -1));
+    
+    BlobStream stream(_connection);
+    EXPECT_FALSE(stream.isOpen());
+    EXPECT_FALSE(stream.open("use_sqlite_table", "d", 10000));
+    EXPECT_FALSE(stream.isOpen());
+    
+    ASSERT_TRUE(stream.open("use_sqlite_table", "d", rowid, true));
+    EXPECT_EQ(size, stream.size());
+    std::istringstream in(payload);
+    EXPECT_TRUE(stream.writeFrom(in, 4096));
+    EXPECT_TRUE(stream.eof());
+    
+    //a blob does not grow
+    EXPECT_FALSE(stream.write("x", 1));
+    EXPECT_FALSE(stream.write("x", 1, size));
+    
+    stream.seek(0);
+    std::ostringstream out;
+    EXPECT_TRUE(stream.readTo(out, 1000));
+    EXPECT_EQ(payload, out.str());
+    
+    //chunks share one buffer
+    stream.seek(size - 10);
+    BlobView chunk = stream.readChunk(8);
+    EXPECT_EQ(8, chunk.size());
+    EXPECT_EQ(payload.substr(size - 10, 8), chunk.str());
+    chunk = stream.readChunk(8);
+    EXPECT_EQ(2, chunk.size());
+    EXPECT_EQ(payload.substr(size - 2), chunk.str());
+    EXPECT_TRUE(stream.readChunk(8).empty());
+    
+    char bytes[4] = {0};
+    EXPECT_TRUE(stream.read(bytes, 4, 100));
+    EXPECT_EQ(payload.substr(100, 4), std::string(bytes, 4));
+    EXPECT_FALSE(stream.read(bytes, 4, size - 2));
+    
+    ASSERT_TRUE(stream.reopen(small));
+    EXPECT_EQ(4, stream.size());
+    EXPECT_TRUE(stream.write("abcd", 4));
+    EXPECT_TRUE(stream.close());
+    EXPECT_FALSE(stream.isOpen());
+    
+    Query query("select a, d from use_sqlite_table order by rowid", _connection);
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(payload, query.blobForColumnIndex(1).str());
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ("abcd", query.blobForColumnIndex(1).str());
+    query.close();
+    
+    //read only
+    ASSERT_TRUE(stream.open("use_sqlite_table", "d", small));
+    EXPECT_FALSE(stream.write("dcba", 4));
+    EXPECT_EQ("abcd", stream.readChunk().str());
+}
+
 TEST_F(USQLTests, query_double)
 {
     EXPECT_TRUE(insertRow("hello world", 10, 12.3));
@@ -371,6 +1238,100 @@ TEST_F(USQLTests, query_double)
     EXPECT_FALSE(query.next());
 }
 
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLTests, query_typed_row)
+{
+    EXPECT_TRUE(insertRow("hello world", 10, 12.3, true));
+    
+    Query query("select a, b, c, e from use_sqlite_table", _connection);
+    std::string a;
+    int64_t b = 0;
+    double c = 0;
+    bool e = false;
+    EXPECT_TRUE(query.next(a, b, c, e));
+    EXPECT_EQ("hello world", a);
+    EXPECT_EQ(10, b);
+    EXPECT_EQ(12.3, c);
+    EXPECT_TRUE(e);
+    
+    auto row = query.row<TextView, int, float>();
+    EXPECT_EQ("hello world", tr1::get<0>(row).str());
+    EXPECT_EQ(10, tr1::get<1>(row));
+    EXPECT_FLOAT_EQ(12.3f, tr1::get<2>(row));
+    
+    //type mismatches decode as the error values, like the named accessors
+    auto mismatch = query.row<int, std::string>();
+    EXPECT_EQ(USQL_ERROR_INTEGER, tr1::get<0>(mismatch));
+    EXPECT_EQ(USQL_ERROR_TEXT, tr1::get<1>(mismatch));
+    EXPECT_FALSE(query.next(a, b));
+    
+    EXPECT_TRUE(query.reset());
+    TestRow value;
+    tr1::tuple<bool> rest;
+    EXPECT_TRUE(query.next(value, rest));
+    EXPECT_EQ("hello world", value.a);
+    EXPECT_EQ(10, value.b);
+    EXPECT_EQ(12.3, value.c);
+    EXPECT_TRUE(tr1::get<0>(rest));
+}
+#endif
+
+TEST_F(USQLTests, query_fetch_batch)
+{
+    for (int i = 0; i < 10; ++i) {
+        std::stringstream ss;
+        ss<<"row "<<i;
+        EXPECT_TRUE(insertRow(ss.str(), i, i * 0.5, i % 2 == 0));
+    }
+    EXPECT_TRUE(_connection.exec("update use_sqlite_table set b = null where b = 5"));
+    
+    Query query("select a, b, c, d from use_sqlite_table order by rowid", _connection);
+    ColumnBatch batch;
+    EXPECT_EQ(0, query.fetch(batch, 0));
+    EXPECT_EQ(4, batch.columnCount());
+    batch.setColumnType(2, _USQL_ENUM_VALUE(ColumnType, Integer));
+    
+    EXPECT_EQ(4, query.fetch(batch, 4));
+    EXPECT_EQ(1, batch.columnIndexForName("b"));
+    
+    const ColumnBatch::Column &a = batch.column(0);
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Text), a.type());
+    EXPECT_EQ("row 0", a.text(0).str());
+    EXPECT_EQ("row 3", a.text(3).str());
+    
+    const ColumnBatch::Column &c = batch.column(2);
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Integer), c.type());
+    EXPECT_EQ(1, c.ints()[3]);
+    
+    const ColumnBatch::Column &d = batch.column(3);
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Null), d.type());
+    EXPECT_TRUE(d.isNull(0));
+    EXPECT_TRUE(d.isNull(3));
+    
+    EXPECT_EQ(4, query.fetch(batch, 4));
+    const ColumnBatch::Column &b = batch.column(1);
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Integer), b.type());
+    EXPECT_EQ(4, b.ints()[0]);
+    EXPECT_TRUE(b.isNull(1));
+    EXPECT_FALSE(b.isNull(2));
+    EXPECT_EQ(7, b.ints()[3]);
+    EXPECT_EQ("row 7", batch.column(0).text(3).str());
+    
+    EXPECT_EQ(2, query.fetch(batch, 4));
+    EXPECT_EQ(2, batch.rowCount());
+    
+    //same column count, other columns
+    Query other("select '' as e, x'' as f, null as g, 1 as h", _connection);
+    EXPECT_EQ(1, other.fetch(batch, 4));
+    EXPECT_EQ(USQL_INVALID_COLUMN_INDEX, batch.columnIndexForName("a"));
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Text), batch.column(0).type());
+    EXPECT_FALSE(batch.column(0).text(0).isNull());
+    EXPECT_TRUE(batch.column(0).text(0).empty());
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Blob), batch.column(1).type());
+    EXPECT_FALSE(batch.column(1).blob(0).isNull());
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Integer), batch.column(3).type());
+}
+
 TEST_F(USQLTests, query_close)
 {
     EXPECT_TRUE(insertRow("hello world", 10, 12.3));
@@ -408,6 +1369,78 @@ TEST_F(USQLTests, cursor_bind)
     EXPECT_TRUE(query.next());
 }
 
+TEST_F(USQLTests, cursor_parameter)
+{
+    const std::string cmd = "insert into use_sqlite_table (a, b, c) values (:a, @b, $c)";
+    Cursor stmt(cmd, _connection);
+    EXPECT_EQ(3, stmt.parameterCount());
+    
+    Parameter a = stmt.parameter(":a");
+    Parameter b = stmt.parameter("@b");
+    Parameter c = stmt.parameter("$c");
+    EXPECT_EQ(1, a.index());
+    EXPECT_EQ(2, b.index());
+    EXPECT_EQ(3, c.index());
+    EXPECT_FALSE(stmt.parameter(":d").valid());
+    EXPECT_FALSE(stmt.parameter("a").valid());
+    EXPECT_FALSE(Parameter().valid());
+    
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(stmt.bind(a, std::string("parameter")));
+        EXPECT_TRUE(stmt.bind(b, i));
+        EXPECT_TRUE(stmt.bind(c, i * 0.5));
+        EXPECT_TRUE(stmt.exec());
+    }
+    EXPECT_FALSE(stmt.bind(stmt.parameter(":d"), 1));
+    
+    //handles stay valid for other cursors of the same sql
+    {
+        Cursor other(cmd, _connection);
+        EXPECT_TRUE(other.bind(b, 3));
+        EXPECT_TRUE(other.bindNull(a));
+        EXPECT_TRUE(other.exec());
+    }
+    
+    Query query("select count(*), sum(b) from use_sqlite_table where a = 'parameter'", _connection);
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(3, query.intForColumnIndex(0));
+    EXPECT_EQ(3, query.intForColumnIndex(1));
+}
+
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLTests, cursor_bind_all)
+{
+    Cursor stmt("insert into use_sqlite_table (a, b, c, e) values (?, ?, ?, ?)", _connection);
+    EXPECT_TRUE(stmt.bindAll(std::string("first"), 1, 1.5, true));
+    EXPECT_TRUE(stmt.exec());
+    
+    //binding after a step starts the next execution
+    EXPECT_TRUE(stmt.bindAll("second", 2, 2.5, false));
+    EXPECT_TRUE(stmt.exec());
+    EXPECT_TRUE(stmt.bindAll(tr1::make_tuple("third", 3, 3.5, nullptr)));
+    EXPECT_TRUE(stmt.exec());
+    
+    //too many values
+    EXPECT_FALSE(stmt.bindAll("fourth", 4, 4.5, true, 5));
+    
+    Query query("select b, c from use_sqlite_table where a = ?", _connection);
+    const char *names[] = {"first", "second", "third"};
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(query.bindAll(names[i]));
+        EXPECT_TRUE(query.next());
+        EXPECT_EQ(i + 1, query.intForName("b"));
+        EXPECT_EQ(i + 1.5, query.floatForName("c"));
+    }
+    
+    //rebinding in the middle of a result set restarts it
+    EXPECT_TRUE(query.bindAll("first"));
+    EXPECT_TRUE(query.next());
+    EXPECT_TRUE(query.bindAll("second"));
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(2, query.intForName("b"));
+}
+#endif
+
 TEST_F(USQLTests, connnection_transaction)
 {
     Query query("select count(*) as row_count from use_sqlite_table", _connection);
@@ -438,6 +1471,75 @@ TEST_F(USQLTests, connnection_transaction)
     query.close();
 }
 
+TEST_F(USQLTests, nested_transaction)
+{
+    _connection.resetTransactionStats();
+    auto count = [this]()->int {
+        Query query("select count(*) from use_sqlite_table", _connection);
+        return query.next() ? query.intForColumnIndex(0) : -1;
+    };
+    
+    {
+        Transaction outer(_connection, _USQL_ENUM_VALUE(TransactionType, Immediate));
+        EXPECT_TRUE(outer.isActive());
+        EXPECT_FALSE(outer.isNested());
+        EXPECT_TRUE(_connection.inTransaction());
+        insertRow("outer", 1, 1.0);
+        
+        {
+            Transaction inner(_connection);
+            EXPECT_TRUE(inner.isNested());
+            EXPECT_EQ(1, _connection.savepointDepth());
+            insertRow("inner", 2, 2.0);
+            
+            {
+                //rolled back by the guard
+                Transaction innermost(_connection);
+                EXPECT_EQ(2, _connection.savepointDepth());
+                insertRow("innermost", 3, 3.0);
+                EXPECT_EQ(3, count());
+            }
+            
+            EXPECT_EQ(1, _connection.savepointDepth());
+            EXPECT_EQ(2, count());
+            EXPECT_TRUE(inner.commit());
+            EXPECT_FALSE(inner.commit());
+        }
+        
+        //the helper nests through Connection::transaction
+        EXPECT_TRUE(_connection.transaction(_USQL_ENUM_VALUE(TransactionType, Deferred), [this](Connection &)->bool {
+            insertRow("helper", 4, 4.0);
+            return false;
+        }));
+        EXPECT_EQ(0, _connection.savepointDepth());
+        EXPECT_EQ(2, count());
+        EXPECT_TRUE(outer.commit());
+    }
+    EXPECT_FALSE(_connection.inTransaction());
+    EXPECT_EQ(2, count());
+    
+    //exceptions unwind through the guard
+    try {
+        Transaction trans(_connection);
+        insertRow("thrown", 5, 5.0);
+        throw std::runtime_error("failed");
+    }
+    catch (const std::runtime_error &) {
+    }
+    EXPECT_FALSE(_connection.inTransaction());
+    EXPECT_EQ(2, count());
+    
+    const Connection::TransactionStats &stats = _connection.transactionStats();
+    EXPECT_EQ(1, stats.commits);
+    EXPECT_EQ(1, stats.rollbacks);
+    EXPECT_EQ(1, stats.savepointReleases);
+    EXPECT_EQ(2, stats.savepointRollbacks);
+    EXPECT_LE(0, stats.totalCommitMilliseconds);
+    EXPECT_LE(stats.maxCommitMilliseconds, stats.totalCommitMilliseconds);
+    
+    EXPECT_FALSE(_connection.releaseSavepoint());
+}
+
 TEST_F(USQLTests, connection_function)
 {
     auto func = [](sqlite3_context* context, std::vector<sqlite3_value *> &argv){
@@ -491,6 +1593,569 @@ TEST_F(USQLTests, connection_aggregate_function)
     EXPECT_EQ(22, query.intForName("max_len"));
 }
 
+TEST_F(USQLTests, connection_typed_function)
+{
+    EXPECT_TRUE(_connection.registerScalar<double(double, double)>("usql_mul", [](double a, double b) {
+        return a * b;
+    }, true));
+    EXPECT_TRUE(_connection.registerScalar<int(TextView)>("usql_text_len", [](TextView text) {
+        return static_cast<int>(text.size());
+    }));
+    EXPECT_TRUE(_connection.registerScalar<std::string(const std::string &, int)>("usql_repeat", [](const std::string &text, int count) {
+        std::string ret;
+        for (int i = 0; i < count; ++i) {
+            ret += text;
+        }
+        return ret;
+    }));
+    EXPECT_TRUE(_connection.registerScalar<sqlite3_int64(sqlite3_int64, bool)>("usql_negate_if", [](sqlite3_int64 value, bool negate) {
+        return negate ? -value : value;
+    }));
+    EXPECT_TRUE(_connection.registerScalar<std::nullptr_t()>("usql_null", []() {
+        return nullptr;
+    }));
+    int calls = 0;
+    EXPECT_TRUE(_connection.registerScalar<void(int)>("usql_count", [&calls](int n) {
+        calls += n;
+    }));
+    EXPECT_TRUE(_connection.registerScalar<int(int)>("usql_throw", [](int) -> int {
+        throw std::runtime_error("usql_throw failed");
+    }));
+    
+    insertRow("hello world", 10, 12.5);
+    Query query("select usql_mul(b, c), usql_text_len(a), usql_repeat('ab', 3), usql_negate_if(1 << 40, 1), usql_text_len(null), usql_null(), usql_count(2) from use_sqlite_table", _connection);
+    ASSERT_TRUE(query.next());
+    EXPECT_DOUBLE_EQ(125.0, query.floatForColumnIndex(0));
+    EXPECT_EQ(11, query.intForColumnIndex(1));
+    EXPECT_EQ("ababab", query.textForColumnIndex(2));
+    EXPECT_EQ(-(static_cast<sqlite3_int64>(1) << 40), query.int64ForColumnIndex(3));
+    EXPECT_EQ(0, query.intForColumnIndex(4));
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Null), query.typeForColumn(5));
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Null), query.typeForColumn(6));
+    EXPECT_EQ(2, calls);
+    query.close();
+    
+    //the argument count is part of the signature
+    Query wrong("select usql_mul(1)", _connection);
+    EXPECT_FALSE(wrong.next());
+    wrong.close();
+    
+    //unsigned int keeps values above INT_MAX both ways
+    EXPECT_TRUE(_connection.registerScalar<unsigned int(unsigned int)>("usql_unsigned", [](unsigned int value) {
+        return value;
+    }));
+    Query unsignedQuery("select usql_unsigned(4000000000)", _connection);
+    ASSERT_TRUE(unsignedQuery.next());
+    EXPECT_EQ(4000000000LL, unsignedQuery.int64ForColumnIndex(0));
+    unsignedQuery.close();
+    
+    Query thrown("select usql_throw(1)", _connection);
+    Result ret = thrown.next();
+    EXPECT_FALSE(ret);
+    EXPECT_EQ("usql_throw failed", ret.description());
+    thrown.close();
+    
+    //the functor is released exactly once, also when sqlite refuses it
+    tr1::shared_ptr<int> owner(new int(0));
+    EXPECT_FALSE(_connection.registerScalar<int()>(std::string(300, 'f'), [owner]() {
+        return *owner;
+    }));
+    EXPECT_EQ(1, owner.use_count());
+    
+    //the untyped path without the vector copy
+    Function *obj = Function::create("usql_arg_count");
+    obj->setArgumentsFunction([](sqlite3_context *context, const FunctionArguments &argv) {
+        int nonnull = 0;
+        for (auto iter = argv.begin(); iter != argv.end(); ++iter) {
+            nonnull += sqlite3_value_type(*iter) != SQLITE_NULL;
+        }
+        sqlite3_result_int(context, nonnull * 100 + static_cast<int>(argv.size()));
+    });
+    EXPECT_TRUE(_connection.registerFunction(obj));
+    Query args("select usql_arg_count(1, null, 'a')", _connection);
+    ASSERT_TRUE(args.next());
+    EXPECT_EQ(203, args.intForColumnIndex(0));
+    args.close();
+    
+    //found again by its argument count
+    _connection.unregisterFunction("usql_mul");
+    Query removed("select usql_mul(1, 2)", _connection);
+    EXPECT_FALSE(removed.next());
+}
+
+TEST_F(USQLTests, connection_typed_aggregate)
+{
+    EXPECT_TRUE(_connection.registerAggregate<TestAverage>("usql_avg", TestAverage(), true));
+    EXPECT_TRUE(_connection.registerAggregate("usql_concat", TestConcat("|")));
+    EXPECT_TRUE(_connection.registerAggregate<TestPositiveSum>("usql_positive_sum"));
+    
+    //a group without rows gets the prototype's value
+    {
+        Query query("select usql_avg(c), usql_concat(a), count(*) from use_sqlite_table", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_DOUBLE_EQ(0, query.floatForColumnIndex(0));
+        EXPECT_EQ("", query.textForColumnIndex(1));
+        EXPECT_EQ(0, query.intForColumnIndex(2));
+    }
+    EXPECT_EQ(0, TestConcat::live - 1);
+    
+    insertRow("a", 1, 1.0);
+    insertRow("b", 1, 2.0);
+    insertRow("c", 2, 10.0);
+    insertRow("d", 1, 3.0);
+    insertRow("e", 2, 20.0);
+    
+    //every group has its own state
+    {
+        Query query("select b, usql_avg(c), usql_concat(a), usql_positive_sum(b) from use_sqlite_table group by b order by b", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(1, query.intForColumnIndex(0));
+        EXPECT_DOUBLE_EQ(2.0, query.floatForColumnIndex(1));
+        EXPECT_EQ("a|b|d", query.textForColumnIndex(2));
+        EXPECT_EQ(3, query.intForColumnIndex(3));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(2, query.intForColumnIndex(0));
+        EXPECT_DOUBLE_EQ(15.0, query.floatForColumnIndex(1));
+        EXPECT_EQ("c|e", query.textForColumnIndex(2));
+        EXPECT_EQ(4, query.intForColumnIndex(3));
+        EXPECT_FALSE(query.next());
+    }
+    //the registered prototype is the only state left
+    EXPECT_EQ(1, TestConcat::live);
+    
+    //an exception fails the statement, the states are still destroyed
+    {
+        Query query("select usql_positive_sum(b - 2), usql_concat(a) from use_sqlite_table", _connection);
+        Result ret = query.next();
+        EXPECT_FALSE(ret);
+        EXPECT_EQ("negative value", ret.description());
+    }
+    EXPECT_EQ(1, TestConcat::live);
+    
+    //abandoned half way
+    {
+        Query query("select b, usql_concat(a) from use_sqlite_table group by b order by b", _connection);
+        ASSERT_TRUE(query.next());
+    }
+    EXPECT_EQ(1, TestConcat::live);
+    
+    _connection.unregisterAllFunctions();
+    EXPECT_EQ(0, TestConcat::live);
+}
+
+#if _USQL_SQLITE_WINDOW_FUNCTION_ENABLE
+TEST_F(USQLTests, connection_window_function)
+{
+    EXPECT_TRUE(_connection.registerWindow<TestAverage>("usql_moving_avg"));
+    
+    WindowFunction *sum = WindowFunction::create("usql_window_sum");
+    sum->setArgumentCount(1);
+    sum->setArgumentsFunction([](sqlite3_context *context, const FunctionArguments &argv) {
+        int64_t *total = static_cast<int64_t *>(sqlite3_aggregate_context(context, sizeof(int64_t)));
+        *total += sqlite3_value_int64(argv[0]);
+    });
+    sum->setInverseFunction([](sqlite3_context *context, const FunctionArguments &argv) {
+        int64_t *total = static_cast<int64_t *>(sqlite3_aggregate_context(context, sizeof(int64_t)));
+        *total -= sqlite3_value_int64(argv[0]);
+    });
+    sum->setValueFunction([](sqlite3_context *context) {
+        int64_t *total = static_cast<int64_t *>(sqlite3_aggregate_context(context, 0));
+        sqlite3_result_int64(context, total ? *total : 0);
+    });
+    sum->setFinalFunction([](sqlite3_context *context) {
+        int64_t *total = static_cast<int64_t *>(sqlite3_aggregate_context(context, 0));
+        sqlite3_result_int64(context, total ? *total : 0);
+    });
+    EXPECT_TRUE(_connection.registerFunction(sum));
+    
+    for (int i = 1; i <= 6; ++i) {
+        insertRow(std::to_string(i), i, i * 1.0);
+    }
+    
+    //the frame slides through value/inverse instead of being rebuilt per row
+    {
+        Query query("select b, usql_moving_avg(c) over w, usql_window_sum(b) over w, avg(c) over w from use_sqlite_table "
+                    "window w as (order by b rows between 2 preceding and current row) order by b", _connection);
+        const double averages[] = {1, 1.5, 2, 3, 4, 5};
+        const int sums[] = {1, 3, 6, 9, 12, 15};
+        for (int i = 0; i < 6; ++i) {
+            ASSERT_TRUE(query.next());
+            EXPECT_EQ(i + 1, query.intForColumnIndex(0));
+            EXPECT_DOUBLE_EQ(averages[i], query.floatForColumnIndex(1));
+            EXPECT_EQ(sums[i], query.intForColumnIndex(2));
+            EXPECT_DOUBLE_EQ(query.floatForColumnIndex(3), query.floatForColumnIndex(1));
+        }
+        EXPECT_FALSE(query.next());
+    }
+    
+    //window functions still work as plain aggregates
+    {
+        Query query("select usql_moving_avg(c), usql_window_sum(b) from use_sqlite_table", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_DOUBLE_EQ(3.5, query.floatForColumnIndex(0));
+        EXPECT_EQ(21, query.intForColumnIndex(1));
+    }
+    
+    //a partition starts from an empty state
+    {
+        Query query("select b, usql_window_sum(b) over (partition by b % 2 order by b rows unbounded preceding) from use_sqlite_table order by b", _connection);
+        const int sums[] = {1, 2, 4, 6, 9, 12};
+        for (int i = 0; i < 6; ++i) {
+            ASSERT_TRUE(query.next());
+            EXPECT_EQ(sums[i], query.intForColumnIndex(1));
+        }
+    }
+    
+    _connection.unregisterAllFunctions();
+    EXPECT_FALSE(_connection.exec("select usql_window_sum(b) over () from use_sqlite_table"));
+}
+#endif
+
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLTests, connection_container_table)
+{
+    std::vector<TestPerson> people;
+    for (int i = 0; i < 1000; ++i) {
+        people.push_back(TestPerson(i, "person " + std::to_string(i), (i * 7) % 100));
+    }
+    
+    auto table = ContainerTable<std::vector<TestPerson> >::create(people);
+    table->addColumn("id", &TestPerson::id, _USQL_ENUM_VALUE(TableIndex, Presorted))
+        .addColumn("name", &TestPerson::name, _USQL_ENUM_VALUE(TableIndex, Indexed))
+        .addColumn("score", &TestPerson::score, _USQL_ENUM_VALUE(TableIndex, Indexed))
+        .addColumn("odd", [](const TestPerson &p) { return p.id % 2 == 1; })
+        .addColumn("label", [](const TestPerson &p) { return "#" + std::to_string(p.id); });
+    EXPECT_EQ(5, table->columnCount());
+    EXPECT_TRUE(_connection.registerTable("usql_people", table));
+    
+    //joins read the vector in place
+    insertRow("x", 10, 1.0);
+    insertRow("y", 500, 2.0);
+    insertRow("z", 5000, 3.0);
+    {
+        Query query("select t.a, p.name, p.label, p.odd from use_sqlite_table t join usql_people p on p.id = t.b order by t.a", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ("x", query.textForColumnIndex(0));
+        EXPECT_EQ("person 10", query.textForColumnIndex(1));
+        EXPECT_EQ("#10", query.textForColumnIndex(2));
+        EXPECT_EQ(0, query.intForColumnIndex(3));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ("person 500", query.textForColumnIndex(1));
+        EXPECT_FALSE(query.next());
+    }
+    
+    {
+        //index 0 is a full scan
+        Query plan("explain query plan select t.a from use_sqlite_table t join usql_people p on p.id = t.b", _connection);
+        std::string details;
+        while (plan.next()) {
+            details += plan.textForColumnIndex(3) + ";";
+        }
+        EXPECT_NE(std::string::npos, details.find("VIRTUAL TABLE INDEX"));
+        EXPECT_EQ(std::string::npos, details.find("INDEX 0:"));
+    }
+    
+    //equality and ranges through the built index, the rowid is the position
+    {
+        Query query("select rowid, id from usql_people where name = 'person 42'", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(42, query.int64ForColumnIndex(0));
+        EXPECT_EQ(42, query.int64ForColumnIndex(1));
+        EXPECT_FALSE(query.next());
+    }
+    {
+        Query query("select count(*), min(score), max(score) from usql_people where score > 10 and score <= 20", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(100, query.intForColumnIndex(0));
+        EXPECT_DOUBLE_EQ(11, query.floatForColumnIndex(1));
+        EXPECT_DOUBLE_EQ(20, query.floatForColumnIndex(2));
+    }
+    {
+        Query query("select count(*) from usql_people where id >= 990.5 or id < 3", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(12, query.intForColumnIndex(0));
+    }
+    
+    //served in index order
+    {
+        const std::string sql = "select score, id from usql_people where score >= 50 order by score";
+        Query plan("explain query plan " + sql, _connection);
+        while (plan.next()) {
+            EXPECT_EQ(std::string::npos, plan.textForColumnIndex(3).find("TEMP B-TREE"));
+        }
+        
+        Query query(sql, _connection);
+        double last = -1;
+        int count = 0;
+        while (query.next()) {
+            EXPECT_LE(last, query.floatForColumnIndex(0));
+            last = query.floatForColumnIndex(0);
+            ++count;
+        }
+        EXPECT_EQ(500, count);
+    }
+    
+    //a constraint of another type is left to sqlite
+    {
+        Query query("select count(*) from usql_people where id = '5' or name = 7 or score < 'a'", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(1000, query.intForColumnIndex(0));
+    }
+    
+    //the index follows the container after invalidate()
+    people[3].name = "zz";
+    people.push_back(TestPerson(1000, "person 3", 0));
+    table->invalidate();
+    {
+        Query query("select id from usql_people where name = 'person 3'", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(1000, query.int64ForColumnIndex(0));
+        EXPECT_FALSE(query.next());
+    }
+    
+    _connection.unregisterTable("usql_people");
+    EXPECT_FALSE(_connection.exec("select * from usql_people"));
+    EXPECT_EQ(1, table.use_count());
+    
+    //null sorts before the empty string, as sqlite orders it
+    struct Name {
+        const char *name;
+    };
+    std::vector<Name> names;
+    const char *values[] = {"", nullptr, "a"};
+    for (int i = 0; i < 3; ++i) {
+        Name name = {values[i]};
+        names.push_back(name);
+    }
+    auto nullable = ContainerTable<std::vector<Name> >::create(names);
+    nullable->addColumn("name", &Name::name, _USQL_ENUM_VALUE(TableIndex, Indexed));
+    EXPECT_TRUE(_connection.registerTable("usql_names", nullable));
+    {
+        Query query("select name is null, name from usql_names order by name", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(1, query.intForColumnIndex(0));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(0, query.intForColumnIndex(0));
+        EXPECT_EQ("", query.textForColumnIndex(1));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ("a", query.textForColumnIndex(1));
+        EXPECT_FALSE(query.next());
+    }
+    {
+        Query query("select count(*) from usql_names where name < 'a'", _connection);
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(1, query.intForColumnIndex(0));
+    }
+    _connection.unregisterTable("usql_names");
+}
+#endif
+
+#if _USQL_SQLITE_BIND_POINTER_ENABLE
+TEST_F(USQLTests, cursor_bind_array)
+{
+    for (int i = 1; i <= 10; ++i) {
+        insertRow("row " + std::to_string(i), i, i * 0.5);
+    }
+    
+    //one statement for every list size
+    const std::string cmd = "select count(*), sum(b) from use_sqlite_table where b in usql_array(?)";
+    uint64_t misses = _connection.statementCacheMisses();
+    {
+        Query query(cmd, _connection);
+        EXPECT_TRUE(query.bind(1, std::vector<int>{1, 3, 5, 42}));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(3, query.intForColumnIndex(0));
+        EXPECT_EQ(9, query.intForColumnIndex(1));
+        
+        EXPECT_TRUE(query.bind(1, std::vector<int64_t>{10}));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(1, query.intForColumnIndex(0));
+        
+        EXPECT_TRUE(query.bind(1, std::vector<int>()));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(0, query.intForColumnIndex(0));
+    }
+    {
+        std::vector<int64_t> ids;
+        for (int i = 0; i < 5000; ++i) {
+            ids.push_back(i);
+        }
+        Query query(cmd, _connection);
+        EXPECT_TRUE(query.bindAll(ids));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(10, query.intForColumnIndex(0));
+        EXPECT_EQ(55, query.intForColumnIndex(1));
+    }
+    EXPECT_EQ(misses + 1, _connection.statementCacheMisses());
+    
+    //text and real lists, bound by name
+    {
+        std::vector<std::string> names;
+        names.push_back("row 2");
+        names.push_back("row 7");
+        names.push_back("no row");
+        Query query("select b from use_sqlite_table where a in usql_array(:names) order by b", _connection);
+        EXPECT_TRUE(query.bind(":names", names));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(2, query.intForColumnIndex(0));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(7, query.intForColumnIndex(0));
+        EXPECT_FALSE(query.next());
+    }
+    {
+        Query query("select rowid, value from usql_array(?)", _connection);
+        EXPECT_TRUE(query.bind(1, std::vector<double>{0.5, 1.5}));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(1, query.intForColumnIndex(0));
+        EXPECT_DOUBLE_EQ(0.5, query.floatForColumnIndex(1));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(2, query.intForColumnIndex(0));
+        EXPECT_DOUBLE_EQ(1.5, query.floatForColumnIndex(1));
+        EXPECT_FALSE(query.next());
+        
+        //a list goes out of range like any other value
+        EXPECT_FALSE(query.bind(2, std::vector<double>{1}));
+    }
+    
+    //a parameter that is no list reads as an empty table
+    {
+        Query query("select count(*) from usql_array(?)", _connection);
+        EXPECT_TRUE(query.bind(1, 5));
+        ASSERT_TRUE(query.next());
+        EXPECT_EQ(0, query.intForColumnIndex(0));
+    }
+}
+#endif
+
+TEST_F(USQLTests, connection_statement_cache)
+{
+    EXPECT_TRUE(insertRow("hello world", 10, 12.3));
+    
+    const std::string cmd = "select * from use_sqlite_table where b = ?";
+    uint64_t hits = _connection.statementCacheHits();
+    uint64_t misses = _connection.statementCacheMisses();
+    for (int i = 0; i < 3; ++i) {
+        Query query(cmd, _connection);
+        EXPECT_TRUE(query.bind(1, 10));
+        EXPECT_TRUE(query.next());
+        EXPECT_EQ("hello world", query.textForName("a"));
+    }
+    EXPECT_EQ(misses + 1, _connection.statementCacheMisses());
+    EXPECT_EQ(hits + 2, _connection.statementCacheHits());
+    
+    {
+        //cached statements come back with cleared bindings
+        Query query(cmd, _connection);
+        EXPECT_FALSE(query.next());
+    }
+    
+    _connection.setStatementCacheCapacity(1);
+    EXPECT_TRUE(_connection.exec("select count(*) from use_sqlite_table"));
+    EXPECT_EQ(1, _connection.statementCacheSize());
+    
+    _connection.setStatementCacheCapacity(0);
+    EXPECT_EQ(0, _connection.statementCacheSize());
+    EXPECT_TRUE(_connection.exec("select count(*) from use_sqlite_table"));
+    EXPECT_EQ(0, _connection.statementCacheSize());
+    
+    _connection.setStatementCacheCapacity(USQL_DEFAULT_STATEMENT_CACHE_CAPACITY);
+    EXPECT_TRUE(_connection.exec("select count(*) from use_sqlite_table"));
+    EXPECT_TRUE(_connection.close());
+    EXPECT_EQ(0, _connection.statementCacheSize());
+}
+
+TEST_F(USQLTests, database_statement_registry)
+{
+    _connection.setStatementCacheCapacity(0);
+    auto db = _connection.database().lock();
+    size_t count = db->statementCount();
+    
+    {
+        Query q1("select a from use_sqlite_table", _connection);
+        Query q2("select b from use_sqlite_table", _connection);
+        Query q3("select c from use_sqlite_table", _connection);
+        EXPECT_EQ(count + 3, db->statementCount());
+        
+        //unlink from the middle
+        q2.close();
+        EXPECT_EQ(count + 2, db->statementCount());
+        
+        //closing finalizes the statements still alive
+        EXPECT_TRUE(_connection.close());
+        EXPECT_EQ(0, db->statementCount());
+        EXPECT_FALSE(q1.next());
+    }
+    
+    EXPECT_EQ(0, db->statementCount());
+}
+
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLTests, bulk_insert)
+{
+    std::vector<std::string> columns;
+    columns.push_back("a");
+    columns.push_back("b");
+    columns.push_back("c");
+    columns.push_back("d");
+    
+    {
+        BulkInserter inserter(_connection, "use_sqlite_table", columns);
+        inserter.setBatchRows(4);
+        EXPECT_EQ("INSERT INTO use_sqlite_table (a, b, c, d) VALUES (?, ?, ?, ?)", inserter.command());
+        
+        for (int i = 0; i < 10; ++i) {
+            std::stringstream ss;
+            ss<<"row "<<i;
+            EXPECT_TRUE(inserter.insert(ss.str(), i, i * 0.5, nullptr));
+        }
+        EXPECT_FALSE(inserter.insert(1, 2));
+        EXPECT_EQ(8, inserter.rowCount());
+        EXPECT_EQ(2, inserter.commitCount());
+        EXPECT_TRUE(inserter.flush());
+        EXPECT_EQ(10, inserter.rowCount());
+        EXPECT_TRUE(inserter.rowsPerSecond() > 0);
+        
+        EXPECT_TRUE(inserter.insert(tr1::make_tuple(std::string("dropped"), 1, 1.0, BlobView())));
+        EXPECT_TRUE(inserter.rollback());
+    }
+    
+    Query query("select a, b, c, d from use_sqlite_table order by rowid", _connection);
+    ColumnBatch batch;
+    EXPECT_EQ(10, query.fetch(batch, 100));
+    EXPECT_EQ("row 9", batch.column(0).text(9).str());
+    EXPECT_EQ(9, batch.column(1).ints()[9]);
+    EXPECT_TRUE(batch.column(3).isNull(9));
+    
+    EXPECT_TRUE(clearTable());
+    {
+        BulkInserter inserter(_connection, "use_sqlite_table", columns);
+        EXPECT_TRUE(inserter.insert(batch));
+    }
+    
+    Query count("select count(*), sum(b) from use_sqlite_table", _connection);
+    EXPECT_TRUE(count.next());
+    EXPECT_EQ(10, count.intForColumnIndex(0));
+    EXPECT_EQ(45, count.intForColumnIndex(1));
+    
+    //empty text and blob are values, not NULL
+    EXPECT_TRUE(clearTable());
+    Query empty("select '', 0, 0.0, x''", _connection);
+    EXPECT_EQ(1, empty.fetch(batch, 100));
+    {
+        BulkInserter inserter(_connection, "use_sqlite_table", columns);
+        EXPECT_TRUE(inserter.insert(batch));
+    }
+    
+    Query nulls("select a isnull, typeof(a), d isnull, typeof(d), length(d) from use_sqlite_table", _connection);
+    EXPECT_TRUE(nulls.next());
+    EXPECT_EQ(0, nulls.intForColumnIndex(0));
+    EXPECT_EQ("text", nulls.textForColumnIndex(1));
+    EXPECT_EQ(0, nulls.intForColumnIndex(2));
+    EXPECT_EQ("blob", nulls.textForColumnIndex(3));
+    EXPECT_EQ(0, nulls.intForColumnIndex(4));
+}
+#endif
+
 #pragma mark - extension tests
 class USQLExtTests : public testing::Test
 {
@@ -650,6 +2315,74 @@ TEST_F(USQLExtTests, insert_row)
     EXPECT_TRUE(std::difftime(query.datetimeForName("f"), ts) < 1);
 }
 
+#if _USQL_TEMPLATE_VARIABLE_PARAMETERS_ENABLE
+TEST_F(USQLExtTests, insert_multi_row)
+{
+    auto create = TableCommand::create(_testTablename);
+    create.createIfNotExist(true)
+    .columnDef("a", "int")
+    .columnDef("b", "text")
+    .columnDef("c", "real");
+    EXPECT_TRUE(_connection.exec(create.command()));
+    
+    std::vector<std::string> columns;
+    columns.push_back("a");
+    columns.push_back("b");
+    columns.push_back("c");
+    
+    auto cmd = InsertCommand(_testTablename);
+    cmd.columns(columns).setMaxVariables(7);
+    EXPECT_EQ(2, cmd.rowsPerChunk());
+    
+    for (int i = 0; i < 5; ++i) {
+        cmd.row(i, std::to_string(i), i * 0.5);
+    }
+    cmd.row(5, nullptr, nullptr);
+    EXPECT_EQ(6, cmd.rowCount());
+    EXPECT_EQ(3, cmd.chunkCount());
+    EXPECT_EQ("INSERT INTO test_table_name (a, b, c) VALUES (?, ?, ?), (?, ?, ?)", cmd.chunkCommand(0));
+    EXPECT_EQ("", cmd.chunkCommand(3));
+    
+    EXPECT_TRUE(cmd.exec(_connection));
+    
+    Query query("select a, b, c from test_table_name order by a", _connection);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(query.next());
+        EXPECT_EQ(i, query.intForName("a"));
+        EXPECT_EQ(std::to_string(i), query.textForName("b"));
+        EXPECT_EQ(i * 0.5, query.floatForName("c"));
+    }
+    EXPECT_TRUE(query.next());
+    EXPECT_EQ(5, query.intForName("a"));
+    EXPECT_EQ(_USQL_ENUM_VALUE(ColumnType, Null), query.typeForName("b"));
+    EXPECT_FALSE(query.next());
+    
+    //a row of the wrong arity fails the whole insert
+    cmd.clearRows();
+    cmd.row(6, "6", 3.0);
+    cmd.row(7, "7");
+    EXPECT_EQ(1, cmd.rowCount());
+    EXPECT_EQ(1, cmd.invalidRowCount());
+    EXPECT_EQ(SQLITE_MISUSE, cmd.exec(_connection).code());
+    cmd.clearRows();
+    EXPECT_EQ(0, cmd.invalidRowCount());
+    
+    //a failing chunk rolls back the chunks before it
+    EXPECT_TRUE(_connection.exec("create unique index test_table_name_a on test_table_name (a)"));
+    for (int i = 10; i < 15; ++i) {
+        cmd.row(i, std::to_string(i), i * 0.5);
+    }
+    cmd.row(0, nullptr, nullptr);
+    EXPECT_EQ(3, cmd.chunkCount());
+    EXPECT_FALSE(cmd.exec(_connection));
+    EXPECT_FALSE(_connection.inTransaction());
+    
+    Query count("select count(*) from test_table_name", _connection);
+    EXPECT_TRUE(count.next());
+    EXPECT_EQ(6, count.intForColumnIndex(0));
+}
+#endif
+
 TEST_F(USQLExtTests, delete_row)
 {
     auto create = TableCommand::create(_testTablename);